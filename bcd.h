@@ -0,0 +1,102 @@
+/*
+ bcd.h
+ Classic Invaders
+
+ Copyright (c) 2013, Todd Steinackle, Simon Que
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the documentation and/or other
+ materials provided with the distribution.
+
+ * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)  nor the names of
+ its contributors may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef BCD_H
+#define BCD_H
+
+#include <stdint.h>
+
+// Number of decimal digits in a BCD value.
+#define BCD_NUM_DIGITS                    8
+
+// Packs the decimal digits of a compile-time constant |x| into BCD, e.g.
+// BCD_CONSTANT(1234) is 0x1234.  Don't use it on values only known at run time,
+// since it divides.
+#define BCD_CONSTANT(x)                                    \
+    ((((uint32_t)(x) / 1UL) % 10) |                        \
+     ((((uint32_t)(x) / 10UL) % 10) << 4) |                \
+     ((((uint32_t)(x) / 100UL) % 10) << 8) |               \
+     ((((uint32_t)(x) / 1000UL) % 10) << 12) |             \
+     ((((uint32_t)(x) / 10000UL) % 10) << 16) |            \
+     ((((uint32_t)(x) / 100000UL) % 10) << 20) |           \
+     ((((uint32_t)(x) / 1000000UL) % 10) << 24) |          \
+     ((((uint32_t)(x) / 10000000UL) % 10) << 28))
+
+// A packed binary-coded decimal number, four bits per digit.  Adding and
+// comparing take a few 32-bit operations, and the digits can be read out for
+// display directly.  A binary number would need a 32-bit division per digit,
+// which is very slow on the AVR.
+class BCD {
+  private:
+    uint32_t value;
+
+  public:
+    BCD() : value(0) {}
+    // |packed| must already be in BCD, e.g. from BCD_CONSTANT().
+    explicit BCD(uint32_t packed) : value(packed) {}
+
+    // Adds |other|.  The top digit does not carry, so sums must stay below
+    // 10^BCD_NUM_DIGITS.
+    void add(const BCD& other) {
+        // Add with every digit but the top one biased by 6, so that a digit
+        // that goes past 9 carries into the next one.  Then take the 6 back
+        // out of each digit that did not carry.
+        uint32_t biased = value + 0x06666666UL;
+        uint32_t sum = biased + other.value;
+        uint32_t carries = sum ^ biased ^ other.value;
+        uint32_t no_carries = ~carries & 0x11111110UL;
+        value = sum - ((no_carries >> 2) | (no_carries >> 3));
+    }
+
+    // Returns digit |index|, where 0 is the least significant.
+    uint8_t get_digit(uint8_t index) const {
+        return (value >> (index * 4)) & 0xf;
+    }
+
+    // Converts to binary, e.g. for printing.  Not for the game loop.
+    uint32_t to_binary() const {
+        uint32_t result = 0;
+        for (int8_t i = BCD_NUM_DIGITS - 1; i >= 0; --i)
+            result = result * 10 + get_digit(i);
+        return result;
+    }
+
+    uint32_t get_packed() const { return value; }
+
+    // Packed BCD values compare the same way as the numbers they hold.
+    bool operator<(const BCD& other) const { return value < other.value; }
+    bool operator>=(const BCD& other) const { return value >= other.value; }
+    bool operator==(const BCD& other) const { return value == other.value; }
+    bool operator!=(const BCD& other) const { return value != other.value; }
+};
+
+#endif  // BCD_H
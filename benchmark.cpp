@@ -0,0 +1,69 @@
+/*
+ benchmark.cpp
+ Classic Invaders
+
+ Copyright (c) 2013, Todd Steinackle, Simon Que
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the documentation and/or other
+ materials provided with the distribution.
+
+ * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)  nor the names of
+ its contributors may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "benchmark.h"
+
+#include <string.h>
+
+#include "printf.h"
+
+void Benchmark::print_header()
+{
+    printf_P("BENCH,scenario,path,iterations,ticks\n");
+}
+
+void Benchmark::end(uint32_t overhead)
+{
+    uint32_t elapsed = System::get_ticks() - start_time;
+    elapsed = (elapsed > overhead) ? elapsed - overhead : 0;
+    printf_P("BENCH,%s,%s,%u,%lu\n", scenario, path, iterations, elapsed);
+}
+
+void BenchmarkState::write_state(const void* data, uint16_t size,
+                                 void* context)
+{
+    BenchmarkState* state = static_cast<BenchmarkState*>(context);
+    if (state->size + size <= BENCHMARK_STATE_SIZE)
+        memcpy(state->data + state->size, data, size);
+    // Keep counting past the end, so is_full() can tell.
+    state->size += size;
+}
+
+bool BenchmarkState::read_state(void* data, uint16_t size, void* context)
+{
+    BenchmarkState* state = static_cast<BenchmarkState*>(context);
+    if (state->position + size > state->size)
+        return false;
+    memcpy(data, state->data + state->position, size);
+    state->position += size;
+    return true;
+}
@@ -0,0 +1,94 @@
+/*
+ benchmark.h
+ Classic Invaders
+
+ Copyright (c) 2013, Todd Steinackle, Simon Que
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the documentation and/or other
+ materials provided with the distribution.
+
+ * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)  nor the names of
+ its contributors may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdint.h>
+
+#include "system.h"
+
+// Define this to run the benchmark suite instead of the game.  See
+// Game::run_benchmarks() for the list of scenarios.
+//#define BENCHMARK
+
+#define BENCHMARK_ITERATIONS          1000
+
+// Room for one saved game state in a BenchmarkState.
+#define BENCHMARK_STATE_SIZE          1024
+
+// Times a number of iterations of a code path and prints the result as a
+// single comma-separated line, so runs of different builds can be diffed:
+//   BENCH,<scenario>,<path>,<iterations>,<total ticks>
+// With the default BENCHMARK_ITERATIONS, the tick count in milliseconds is
+// also the cost of one iteration in microseconds.
+class Benchmark {
+  private:
+    const char* scenario;
+    const char* path;
+    uint16_t iterations;
+    uint32_t start_time;
+
+  public:
+    // Prints the column names.  Call once before running any benchmark.
+    static void print_header();
+
+    void begin(const char* scenario, const char* path, uint16_t iterations) {
+        this->scenario = scenario;
+        this->path = path;
+        this->iterations = iterations;
+        start_time = System::get_ticks();
+    }
+
+    // Stops the timer and prints the result, less |overhead| ticks spent on
+    // setting up the iterations.
+    void end(uint32_t overhead = 0);
+};
+
+// A game state saved in memory, so that every iteration of a benchmark can
+// start from the same point.  Pass write_state() or read_state() to a
+// StateStream, with the BenchmarkState as the context.
+struct BenchmarkState {
+    uint8_t data[BENCHMARK_STATE_SIZE];
+    uint16_t size;        // Number of bytes written.
+    uint16_t position;    // Number of bytes read since the last rewind().
+
+    BenchmarkState() : size(0), position(0) {}
+    void rewind() { position = 0; }
+
+    // Stops writing at the end of |data|.  Check for this with is_full().
+    static void write_state(const void* data, uint16_t size, void* context);
+    static bool read_state(void* data, uint16_t size, void* context);
+    bool is_full() const { return size > BENCHMARK_STATE_SIZE; }
+};
+
+#endif  // BENCHMARK_H
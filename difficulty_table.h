@@ -0,0 +1,188 @@
+// Generated by tools/gen_difficulty_table.py.  Do not edit.
+
+#ifndef DIFFICULTY_TABLE_H
+#define DIFFICULTY_TABLE_H
+
+#include <stdint.h>
+
+#include <avr/pgmspace.h>
+
+#define NUM_DIFFICULTY_WAVES           16
+#define DIFFICULTY_TABLE_NUM_ALIENS    60
+
+struct WaveDifficulty {
+    uint16_t alien_shot_delay;
+    uint8_t num_alien_shots;
+    uint8_t alien_odd_range;
+    uint8_t bonus_select_max;
+    uint8_t launch_delay_max;
+};
+
+const WaveDifficulty kWaveDifficulty[NUM_DIFFICULTY_WAVES] PROGMEM = {
+    { 400, 16, 10, 5, 4 },
+    { 375, 17, 9, 5, 4 },
+    { 350, 18, 8, 4, 3 },
+    { 325, 19, 8, 4, 3 },
+    { 300, 20, 7, 3, 3 },
+    { 275, 21, 6, 2, 3 },
+    { 255, 24, 6, 2, 2 },
+    { 235, 27, 6, 2, 2 },
+    { 215, 30, 6, 2, 2 },
+    { 195, 32, 6, 2, 2 },
+    { 195, 32, 6, 2, 2 },
+    { 195, 32, 6, 2, 2 },
+    { 195, 32, 6, 2, 2 },
+    { 195, 32, 6, 2, 2 },
+    { 195, 32, 6, 2, 2 },
+    { 195, 32, 6, 2, 2 },
+};
+
+// Alien speed in fixed point, indexed by wave and the number of aliens left.
+const int16_t kAlienSpeeds[NUM_DIFFICULTY_WAVES][DIFFICULTY_TABLE_NUM_ALIENS + 1] PROGMEM = {
+    {
+        0, 5993, 5100, 4340, 4241, 3609, 3527, 3447, 3369, 3292,
+        3217, 3144, 3072, 3002, 2934, 2867, 2802, 2738, 2676, 2615,
+        2556, 2498, 2441, 2386, 2332, 2279, 2227, 2176, 2127, 2079,
+        2032, 1986, 1941, 1897, 1854, 1812, 1771, 1731, 1692, 1654,
+        1617, 1580, 1544, 1509, 1475, 1442, 1409, 1377, 1346, 1316,
+        1286, 1257, 1229, 1201, 1174, 1148, 1122, 1097, 1072, 1048,
+        1024,
+    },
+    {
+        0, 6178, 5257, 4474, 4372, 3720, 3635, 3552, 3471, 3392,
+        3315, 3240, 3166, 3094, 3024, 2955, 2888, 2822, 2758, 2695,
+        2634, 2574, 2516, 2459, 2403, 2348, 2295, 2243, 2192, 2142,
+        2093, 2046, 2000, 1955, 1911, 1868, 1826, 1785, 1745, 1706,
+        1667, 1629, 1592, 1556, 1521, 1487, 1453, 1420, 1388, 1357,
+        1326, 1296, 1267, 1238, 1210, 1183, 1156, 1130, 1105, 1080,
+        1056,
+    },
+    {
+        0, 6379, 5428, 4619, 4514, 3841, 3754, 3669, 3585, 3503,
+        3423, 3345, 3269, 3195, 3122, 3051, 2982, 2914, 2848, 2783,
+        2720, 2658, 2598, 2539, 2481, 2425, 2370, 2316, 2263, 2212,
+        2162, 2113, 2065, 2018, 1972, 1927, 1883, 1840, 1798, 1757,
+        1717, 1678, 1640, 1603, 1567, 1532, 1497, 1463, 1430, 1398,
+        1366, 1335, 1305, 1276, 1247, 1219, 1192, 1165, 1139, 1113,
+        1088,
+    },
+    {
+        0, 6561, 5583, 4751, 4643, 3951, 3861, 3773, 3687, 3603,
+        3521, 3441, 3363, 3286, 3211, 3138, 3067, 2997, 2929, 2862,
+        2797, 2733, 2671, 2610, 2551, 2493, 2436, 2381, 2327, 2274,
+        2222, 2172, 2123, 2075, 2028, 1982, 1937, 1893, 1850, 1808,
+        1767, 1727, 1688, 1650, 1613, 1577, 1541, 1506, 1472, 1439,
+        1407, 1375, 1344, 1314, 1284, 1255, 1227, 1199, 1172, 1146,
+        1120,
+    },
+    {
+        0, 6741, 5736, 4881, 4770, 4059, 3967, 3877, 3789, 3703,
+        3619, 3537, 3456, 3377, 3300, 3225, 3152, 3080, 3010, 2942,
+        2875, 2810, 2746, 2684, 2623, 2563, 2505, 2448, 2392, 2338,
+        2285, 2233, 2182, 2133, 2085, 2038, 1992, 1947, 1903, 1860,
+        1818, 1777, 1737, 1698, 1660, 1622, 1585, 1549, 1514, 1480,
+        1447, 1414, 1382, 1351, 1321, 1291, 1262, 1234, 1206, 1179,
+        1152,
+    },
+    {
+        0, 6941, 5906, 5026, 4911, 4180, 4085, 3992, 3901, 3812,
+        3725, 3640, 3557, 3476, 3397, 3320, 3244, 3170, 3098, 3028,
+        2959, 2892, 2826, 2762, 2699, 2638, 2578, 2519, 2462, 2406,
+        2351, 2298, 2246, 2195, 2145, 2096, 2048, 2002, 1957, 1913,
+        1870, 1828, 1787, 1747, 1707, 1668, 1630, 1593, 1557, 1522,
+        1488, 1454, 1421, 1389, 1358, 1327, 1297, 1268, 1239, 1211,
+        1184,
+    },
+    {
+        0, 7036, 5987, 5095, 4979, 4237, 4140, 4046, 3954, 3864,
+        3776, 3690, 3606, 3524, 3444, 3366, 3289, 3214, 3141, 3070,
+        3000, 2932, 2865, 2800, 2736, 2674, 2613, 2554, 2496, 2439,
+        2384, 2330, 2277, 2225, 2175, 2126, 2078, 2031, 1985, 1940,
+        1896, 1853, 1811, 1770, 1730, 1691, 1653, 1616, 1579, 1543,
+        1508, 1474, 1441, 1408, 1376, 1345, 1315, 1285, 1256, 1228,
+        1200,
+    },
+    {
+        0, 7143, 6078, 5172, 5054, 4301, 4203, 4107, 4013, 3922,
+        3833, 3746, 3661, 3578, 3497, 3417, 3339, 3263, 3189, 3116,
+        3045, 2976, 2908, 2842, 2777, 2714, 2652, 2592, 2533, 2475,
+        2419, 2364, 2310, 2258, 2207, 2157, 2108, 2060, 2013, 1967,
+        1922, 1878, 1835, 1793, 1752, 1712, 1673, 1635, 1598, 1562,
+        1527, 1493, 1459, 1426, 1394, 1363, 1332, 1302, 1273, 1244,
+        1216,
+    },
+    {
+        0, 7212, 6137, 5222, 5103, 4343, 4244, 4147, 4053, 3961,
+        3871, 3783, 3697, 3613, 3531, 3451, 3372, 3295, 3220, 3147,
+        3075, 3005, 2937, 2870, 2805, 2741, 2679, 2618, 2559, 2501,
+        2444, 2389, 2335, 2282, 2230, 2179, 2130, 2082, 2035, 1989,
+        1944, 1900, 1857, 1815, 1774, 1734, 1695, 1657, 1620, 1583,
+        1547, 1512, 1478, 1445, 1412, 1380, 1349, 1319, 1289, 1260,
+        1232,
+    },
+    {
+        0, 7332, 6239, 5309, 5188, 4415, 4314, 4216, 4120, 4026,
+        3934, 3844, 3756, 3670, 3586, 3504, 3424, 3346, 3270, 3196,
+        3123, 3052, 2983, 2915, 2849, 2784, 2721, 2659, 2599, 2540,
+        2482, 2426, 2371, 2317, 2264, 2213, 2163, 2114, 2066, 2019,
+        1973, 1928, 1884, 1841, 1799, 1758, 1718, 1679, 1641, 1604,
+        1568, 1533, 1498, 1464, 1431, 1399, 1367, 1336, 1306, 1277,
+        1248,
+    },
+    {
+        0, 7414, 6309, 5369, 5247, 4465, 4363, 4264, 4167, 4072,
+        3979, 3888, 3799, 3712, 3627, 3544, 3463, 3384, 3307, 3232,
+        3158, 3086, 3016, 2947, 2880, 2815, 2751, 2688, 2627, 2567,
+        2509, 2452, 2396, 2342, 2289, 2237, 2186, 2136, 2088, 2041,
+        1995, 1950, 1906, 1863, 1821, 1780, 1740, 1701, 1663, 1625,
+        1588, 1552, 1517, 1483, 1450, 1417, 1385, 1354, 1323, 1293,
+        1264,
+    },
+    {
+        0, 7517, 6397, 5444, 5320, 4527, 4424, 4323, 4224, 4128,
+        4034, 3942, 3852, 3764, 3678, 3594, 3512, 3432, 3354, 3278,
+        3203, 3130, 3059, 2989, 2921, 2855, 2790, 2727, 2665, 2604,
+        2545, 2487, 2431, 2376, 2322, 2269, 2218, 2168, 2119, 2071,
+        2024, 1978, 1933, 1889, 1846, 1804, 1763, 1723, 1684, 1646,
+        1609, 1573, 1537, 1502, 1468, 1435, 1403, 1371, 1340, 1310,
+        1280,
+    },
+    {
+        0, 7604, 6471, 5506, 5380, 4578, 4474, 4372, 4272, 4175,
+        4080, 3987, 3896, 3807, 3720, 3635, 3552, 3471, 3392, 3315,
+        3240, 3166, 3094, 3024, 2955, 2888, 2822, 2758, 2695, 2634,
+        2574, 2516, 2459, 2403, 2348, 2295, 2243, 2192, 2142, 2093,
+        2046, 2000, 1955, 1911, 1868, 1826, 1785, 1745, 1706, 1667,
+        1629, 1592, 1556, 1521, 1487, 1453, 1420, 1388, 1357, 1326,
+        1296,
+    },
+    {
+        0, 7703, 6555, 5578, 5451, 4639, 4533, 4430, 4329, 4230,
+        4134, 4040, 3948, 3858, 3770, 3684, 3600, 3518, 3438, 3360,
+        3284, 3209, 3136, 3065, 2995, 2927, 2860, 2795, 2731, 2669,
+        2608, 2549, 2491, 2434, 2379, 2325, 2272, 2220, 2170, 2121,
+        2073, 2026, 1980, 1935, 1891, 1848, 1806, 1765, 1725, 1686,
+        1648, 1611, 1575, 1539, 1504, 1470, 1437, 1405, 1373, 1342,
+        1312,
+    },
+    {
+        0, 7793, 6631, 5642, 5513, 4692, 4585, 4480, 4378, 4278,
+        4181, 4086, 3993, 3902, 3813, 3726, 3641, 3558, 3477, 3398,
+        3321, 3245, 3171, 3099, 3029, 2960, 2893, 2827, 2763, 2700,
+        2639, 2579, 2520, 2463, 2407, 2352, 2299, 2247, 2196, 2146,
+        2097, 2049, 2003, 1958, 1914, 1871, 1829, 1788, 1748, 1708,
+        1669, 1631, 1594, 1558, 1523, 1489, 1455, 1422, 1390, 1359,
+        1328,
+    },
+    {
+        0, 7888, 6712, 5712, 5582, 4750, 4642, 4536, 4433, 4332,
+        4233, 4137, 4043, 3951, 3861, 3773, 3687, 3603, 3521, 3441,
+        3363, 3286, 3211, 3138, 3067, 2997, 2929, 2862, 2797, 2733,
+        2671, 2610, 2551, 2493, 2436, 2381, 2327, 2274, 2222, 2172,
+        2123, 2075, 2028, 1982, 1937, 1893, 1850, 1808, 1767, 1727,
+        1688, 1650, 1613, 1577, 1541, 1506, 1472, 1439, 1407, 1375,
+        1344,
+    },
+};
+
+#endif  // DIFFICULTY_TABLE_H
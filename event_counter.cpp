@@ -46,6 +46,18 @@ void EventCounter::new_loop()
     }
 }
 
+void EventCounter::new_wave(int wave)
+{
+    if (wave > 1) {
+        printf_P("Minimum free stack in wave %d: %u bytes\n",
+                 wave - 1, System::get_min_free_stack());
+    } else {
+        printf_P("Minimum free stack at startup: %u bytes\n",
+                 System::get_min_free_stack());
+    }
+    System::paint_stack();
+}
+
 void EventCounter::report()
 {
     if (num_loops == 0)
@@ -53,6 +65,13 @@ void EventCounter::report()
     printf_P("Average stats over last %d loops:\n", num_loops);
     printf_P("- Collision checks: %d\n", num_collision_checks / num_loops);
     printf_P("- Movement calls: %d\n", num_movement_calls / num_loops);
+    printf_P("- Video writes (bytes) for sprite, tilemap, palette, scroll, "
+             "control: ");
+    for (int i = 0; i < NUM_VIDEO_WRITE_CATEGORIES; ++i) {
+        printf_P("%lu (%lu) ", num_video_writes[i] / num_loops,
+                 num_video_bytes[i] / num_loops);
+    }
+    printf_P("\n");
     printf_P("- Loop time in ticks: %d\n",
              (latest_time - game_loop_start_time) / num_loops);
     uint32_t total_game_logic_time = 0;
@@ -42,6 +42,16 @@
 #define EVENT_COUNTER_LOOP_LIMIT        100
 #define MAX_GAME_LOGIC_SECTIONS           8
 
+// Categories of writes to the video controller.
+enum VideoWriteCategory {
+    VIDEO_WRITE_SPRITE,
+    VIDEO_WRITE_TILEMAP,
+    VIDEO_WRITE_PALETTE,
+    VIDEO_WRITE_SCROLL,
+    VIDEO_WRITE_CONTROL,     // Everything else, e.g. tile layer setup.
+    NUM_VIDEO_WRITE_CATEGORIES,
+};
+
 // To improve performance, count the number of various calls per game cycle.
 // This should reveal the bottlenecks where optimization could help.
 class EventCounter {
@@ -50,6 +60,11 @@ class EventCounter {
     uint32_t num_collision_checks;
     uint32_t num_movement_calls;
 
+    // Total number of writes to the video controller and bytes written, for
+    // each VideoWriteCategory.
+    uint32_t num_video_writes[NUM_VIDEO_WRITE_CATEGORIES];
+    uint32_t num_video_bytes[NUM_VIDEO_WRITE_CATEGORIES];
+
     // Total number of game loops elapsed.
     uint32_t num_loops;
 
@@ -83,6 +98,11 @@ class EventCounter {
         ++num_movement_calls;
     }
 
+    void do_video_write(VideoWriteCategory category, uint16_t size) {
+        ++num_video_writes[category];
+        num_video_bytes[category] += size;
+    }
+
     void start_game_logic_section(int section) {
         if (section >= MAX_GAME_LOGIC_SECTIONS)
             return;
@@ -99,6 +119,10 @@ class EventCounter {
     // Tell EventCounter that a new game loop has started.
     void new_loop();
 
+    // Tell EventCounter that wave |wave| is about to start.  Reports the
+    // minimum free stack since the previous wave, and starts measuring again.
+    void new_wave(int wave);
+
     // Prints a report of the current stats.
     void report();
 };
@@ -0,0 +1,25 @@
+// Generated by tools/gen_font_atlas.py.  Do not edit.
+
+#ifndef FONT_ATLAS_H
+#define FONT_ATLAS_H
+
+#include <stdint.h>
+
+#include <avr/pgmspace.h>
+
+#define FONT_NUM_TILES             42
+#define FONT_NUM_SHADES            16
+#define FONT_FIRST_CHAR          ' '
+#define FONT_LAST_CHAR           '~'
+
+// Atlas tile of each character from FONT_FIRST_CHAR to FONT_LAST_CHAR.
+const uint8_t kFontGlyphTiles[] PROGMEM = {
+    0, 37, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 38, 39, 41,
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 40, 0, 0, 0, 0, 0,
+    0, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,
+    26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 0, 0, 0, 0, 0,
+    0, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,
+    26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 0, 0, 0, 0,
+};
+
+#endif  // FONT_ATLAS_H
@@ -0,0 +1,61 @@
+/*
+ frame_budget.cpp
+ Classic Invaders
+
+ Copyright (c) 2013, Todd Steinackle, Simon Que
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the documentation and/or other
+ materials provided with the distribution.
+
+ * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)  nor the names of
+ its contributors may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "frame_budget.h"
+
+#include "printf.h"
+
+#define MAX_DEGRADATION_LEVEL       3
+
+void FrameBudget::end_frame()
+{
+    if (work_ticks > FRAME_BUDGET_TICKS) {
+        frames_within_budget = 0;
+        if (level < MAX_DEGRADATION_LEVEL) {
+            ++level;
+#ifdef FRAME_BUDGET_LOG
+            printf_P("Frame took %u ticks, degradation level is now %u\n",
+                     work_ticks, level);
+#endif
+        }
+    } else if (level > 0 && work_ticks <= FRAME_BUDGET_TICKS * 3 / 4) {
+        // Only recover after a run of frames with some headroom, so the level
+        // doesn't go back and forth every frame.
+        if (++frames_within_budget >= FRAME_BUDGET_RECOVERY_FRAMES) {
+            frames_within_budget = 0;
+            --level;
+        }
+    } else {
+        frames_within_budget = 0;
+    }
+    work_ticks = 0;
+}
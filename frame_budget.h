@@ -0,0 +1,95 @@
+/*
+ frame_budget.h
+ Classic Invaders
+
+ Copyright (c) 2013, Todd Steinackle, Simon Que
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the documentation and/or other
+ materials provided with the distribution.
+
+ * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)  nor the names of
+ its contributors may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef FRAME_BUDGET_H
+#define FRAME_BUDGET_H
+
+#include <stdint.h>
+
+#include "screen.h"
+#include "system.h"
+
+// Define this to print a message whenever the degradation level goes up.  The
+// printing happens in a frame that is already over budget and makes it later
+// still, so only use it for debugging.
+//#define FRAME_BUDGET_LOG
+
+// Amount of game logic and drawing time that fits between two vertical blanks.
+#define FRAME_BUDGET_TICKS                FRAME_PERIOD_TICKS
+
+// Number of frames in a row that have to be well within the budget before the
+// degradation level is lowered again.
+#define FRAME_BUDGET_RECOVERY_FRAMES        30
+
+// Measures the time each frame spends on game logic and drawing, excluding
+// waits for the display.  When a frame goes over budget, raises a degradation
+// level that tells the game to skip less important work:
+//   1. Don't scroll the starfields.
+//   2. Upload at most one run of shield tiles per frame.
+//   3. Redraw only half of the aliens each frame.
+// This drops visual detail instead of dropping frames.
+class FrameBudget {
+  private:
+    uint32_t section_start_time;
+    uint16_t work_ticks;              // Work time so far in this frame.
+    uint8_t level;                    // Current degradation level.
+    uint8_t frames_within_budget;
+
+  public:
+    FrameBudget() {
+        reset();
+    }
+
+    void reset() {
+        work_ticks = 0;
+        level = 0;
+        frames_within_budget = 0;
+        section_start_time = System::get_ticks();
+    }
+
+    // Call these around each part of the frame that does work.
+    void start_work() {
+        section_start_time = System::get_ticks();
+    }
+    void end_work() {
+        work_ticks += System::get_ticks() - section_start_time;
+    }
+
+    // Updates the degradation level based on the work time of the frame.
+    void end_frame();
+
+    bool skip_starfield_scroll() const { return level >= 1; }
+    bool defer_shield_uploads() const { return level >= 2; }
+    bool split_alien_redraws() const { return level >= 3; }
+};
+
+#endif  // FRAME_BUDGET_H
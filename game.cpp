@@ -32,14 +32,20 @@
 
 #include "game.h"
 
+#include "difficulty_table.h"
 #include "game_defs.h"
 #include "game_entity.h"
+#include "latency_monitor.h"
 #include "printf.h"
 #include "screen.h"
 #include "shields.h"
 #include "starfield.h"
 #include "system.h"
 
+#if DIFFICULTY_TABLE_NUM_ALIENS != NUM_ALIENS
+#error "difficulty_table.h is out of date, run tools/gen_difficulty_table.py."
+#endif
+
 extern const char* datadir;
 
 //#define FRAME_COUNTER
@@ -55,13 +61,19 @@ using GameEntities::Explosion;
 using GameEntities::Shot;
 
 using Game::ShieldPiece;
-using Game::ShieldGroupTiles;
+using Game::ShieldTiles;
 
 #ifdef EVENT_COUNTER
 EventCounter event_counter;
 #endif
 
+#ifdef LATENCY_MONITOR
+LatencyMonitor latency_monitor;
+#endif
+
 #define PAUSE_COOLDOWN_TIME      100
+// How often to check for the pause key while paused.
+#define PAUSE_POLL_TIME           10
 
 #define max(a, b)   ( ((a)>=(b)) ? (a) : (b) )
 #define min(a, b)   ( ((b)>=(a)) ? (a) : (b) )
@@ -69,6 +81,18 @@ EventCounter event_counter;
 #define STARFIELD_LAYER_INDEX    0
 #define STARFIELD2_LAYER_INDEX   1
 #define SHIELD_LAYER_INDEX       3
+#define TEXT_LAYER_INDEX         2
+
+// Where messages are drawn, in text tiles.
+#define MESSAGE_ROW              ((screen_h / SCREEN_TILE_SIZE) / 2)
+#define MESSAGE_WIDTH            (screen_w / SCREEN_TILE_SIZE)
+#define WAVE_MESSAGE_TIME        1000
+
+// Both bits of Game::redraw_formation: the even and the odd aliens.
+#define ALL_ALIEN_PARITIES       3
+
+// VRAM offset of the font atlas, set by the resource loader.
+extern uint16_t g_font_vram_offset;
 
 namespace {
 
@@ -81,8 +105,15 @@ namespace {
     GAME_ENTITY_ALIEN,
   };
 
-  // Keep count of per-type index offsets in each row.
-  uint8_t per_type_index_offsets[ALIEN_ARRAY_HEIGHT] = { 0, 0, 0, 0, 0 };
+  // Index of the first alien in each row, relative to other aliens of the
+  // same type.  Must be kept consistent with |kAlienTypesByRow|.
+  const uint8_t kAlienIndexOffsetsByRow[ALIEN_ARRAY_HEIGHT] = {
+    0,
+    0,
+    ALIEN_ARRAY_WIDTH,
+    0,
+    ALIEN_ARRAY_WIDTH,
+  };
 
   inline int get_alien_type_by_row(int row) {
     return kAlienTypesByRow[row];
@@ -106,7 +137,7 @@ namespace {
         int launch_delay_array[random_list_len];
 
         GameEntity shield_group_array[NUM_SHIELD_GROUPS];
-        ShieldGroupTiles shield_group_tiles_array[NUM_SHIELD_GROUPS];
+        ShieldTiles shield_tiles;
     };
 
     // Initializes a shield piece entity given its index and state.
@@ -118,25 +149,44 @@ namespace {
         object->ShieldPiece_init(0, x, y, piece.intact);
     }
 
-    fixed increase_speed(fixed speed, fixed32 increase) {
-        // Multiplying fixed and fixed32 results in 12 bits after the point.
-        // FIXED32_TO_INT() converts it back into 4-bit post-point precision.
-        fixed new_speed = FIXED32_TO_INT(speed * increase);
-        if (new_speed != speed || speed == 0)
-            return new_speed;
-        // If the increase was so small that speed was not updated, inc/dec the
-        // speed by 1 so it is still updated.
-        if (speed > 0)
-            return speed + 1;
-        else
-            return speed - 1;
-     }
+    // Returns the number of samples between beats of the background march
+    // when the aliens move at |alien_speed|: one beat per MARCH_STEP_DISTANCE
+    // pixels, so the march speeds up with the aliens.  Returns 0 if the
+    // aliens are not moving.
+    uint16_t get_march_interval(fixed alien_speed) {
+        if (alien_speed < 0)
+            alien_speed = -alien_speed;
+        if (alien_speed == 0)
+            return 0;
+        int32_t interval = (int32_t)SOUND_SAMPLE_RATE *
+                           INT_TO_FIXED(MARCH_STEP_DISTANCE) / alien_speed;
+        if (interval < MARCH_MIN_INTERVAL)
+            return MARCH_MIN_INTERVAL;
+        if (interval > UINT16_MAX)
+            return UINT16_MAX;
+        return interval;
+    }
+
+    // Returns the row of the difficulty tables to use for |wave|, which
+    // starts from 0.  Waves past the end of the tables use the last row.
+    uint8_t get_difficulty_wave(int wave) {
+        if (wave >= NUM_DIFFICULTY_WAVES)
+            return NUM_DIFFICULTY_WAVES - 1;
+        return wave;
+    }
+
+    // Returns the alien speed magnitude for |wave| when |alien_count| aliens
+    // are left.
+    fixed get_alien_speed(int wave, int alien_count) {
+        return pgm_read_word(
+                &kAlienSpeeds[get_difficulty_wave(wave)][alien_count]);
+    }
 
     // Generates a full alien object.
     void make_alien(const Game::ReducedAlien& alien, const Alien* reference,
                     Alien* new_alien) {
         uint8_t type = get_alien_type_by_row(alien.row);
-        uint8_t index = per_type_index_offsets[alien.row] + alien.col;
+        uint8_t index = kAlienIndexOffsetsByRow[alien.row] + alien.col;
         int x = reference->get_x() + alien.col * ALIEN_STEP_X;
         int y = reference->get_y() + alien.row * ALIEN_STEP_Y;
         new_alien->Alien_init(type, index, x, y,
@@ -181,7 +231,7 @@ namespace Game {
         launch_delay = data.launch_delay_array;
 
         shield_groups = data.shield_group_array;
-        shield_group_tiles = data.shield_group_tiles_array;
+        shield_tiles = &data.shield_tiles;
 
         // Instantiate these here, instead of allocating from heap.
         Player player_obj;
@@ -193,115 +243,41 @@ namespace Game {
         sbonus = &small_bonus_obj;
 
         // init for new game
-        wave = score = 0;
-        next_free_guy = free_guy_val;
+        wave = 0;
+        score = BCD();
+        next_free_guy = BCD(BCD_CONSTANT(free_guy_val));
         aliens_landed = false;
-        current_alien_speed = INT_TO_FIXED(ALIEN_BASE_SPEED);
         player_life = 3;
+        num_frames = 0;
+        rand_list_count = alien_to_fire = 0;
 
-        init_wave();
-        game_loop();
-    }
-    void Game::init_wave()
-    {
-        // create conditions for next wave
-        logic_this_loop = wave_over = false;
-        last_shot = 0;
-        player_shot_counter = alien_shot_counter = explosion_counter = 0;
-        factory();
-        // output wave message and status display
-        //ui.wave_msg(++wave);
-        //sound.play_start_wave();
-        screen.update();
-        //status.blit_wave(wave);
-        //status.blit_score(score);
-        //status.blit_lives(player_life);
-        //status.blit_player_ships(player_life, images.get_image_index("ship.png"));
-    }
-    void Game::init_aliens(int rand_max)
-    {
-        // Keep count of both the total number of aliens and the number of each
-        // type of alien.
-        alien_count = 0;
-        uint8_t alien_type_counts[NUM_GAME_ENTITY_TYPES];
-        memset(alien_type_counts, 0, sizeof(alien_type_counts));
-        // Create a formation of aliens.
-        for (int row = 0; row < ALIEN_ARRAY_HEIGHT; ++row) {
-            int type = get_alien_type_by_row(row);
-            // For the first alien in each row, store its index relative to
-            // other aliens of its own class.
-            per_type_index_offsets[row] = alien_type_counts[type];
-            for (int col = 0; col < ALIEN_ARRAY_WIDTH; ++col) {
-                // Populate the alien count for each column.  This is redundant
-                // because it goes through the same initialization
-                // |ALIEN_ARRAY_HEIGHT| times, but it saves code space by not
-                // having a separate for loop from 0 to |ALIEN_ARRAY_WIDTH - 1|.
-                num_aliens_per_col[col] = ALIEN_ARRAY_HEIGHT;
-
-                // initialize the bottom row of aliens to fire
-                bool active = (row == ALIEN_ARRAY_HEIGHT - 1);
-                int index = alien_type_counts[type]++;
-
-                // Instantiate an alien.
-                Alien temp_alien;
-                temp_alien.Alien_init(type, index, ALIEN_BASE_X, ALIEN_BASE_Y,
-                                      active, rand() % (rand_max + 1));
-
-                // Convert it to a reduced alien.
-                ReducedAlien& alien = aliens[alien_count];
-                alien.alive = temp_alien.is_alive();
-                alien.active = temp_alien.is_active();
-                alien.dirty = temp_alien.is_dirty();
-                alien.fire_chance = temp_alien.get_fire_chance();
-                alien.row = row;
-                alien.col = col;
+        setup_game();
 
-                // If this is the first alien, save it as a reference.
-                if (alien_count == 0) {
-                  *reference_alien = temp_alien;
+#ifdef BENCHMARK
+        init_wave();
+        run_benchmarks();
+#else
+        // Keep playing waves until the game is over.
+        do {
+            init_wave();
+            if (initial_state_reader) {
+                if (!load_state(initial_state_reader,
+                                initial_state_reader_context)) {
+                    printf_P("Could not load initial game state.\n");
                 }
-                ++alien_count;
+                initial_state_reader = NULL;
             }
-        }
-        // create alien shots
-        for (int i = 0; i < num_alien_shots; ++i) {
-            alien_shots[i].Shot_init(num_player_shots + i, 0, 0, false);
-        }
+            game_loop();
+        } while (player_life && !aliens_landed);
+#ifdef LATENCY_MONITOR
+        // There is no next wave to report this one.
+        printf_P("Input latency in wave %d:\n", wave);
+        latency_monitor.report();
+#endif
+#endif
     }
-    void Game::factory()
+    void Game::setup_game()
     {
-        // create the player ship and place it in the center of the screen
-        player->Player_init(player_center, player_top, true);
-        current_player_speed = 0;
-
-        // create bonus ship and small bonus ship
-        bonus->BonusShip_init(false, 0, 0, false);
-        sbonus->BonusShip_init(true, 0, 0, false);
-        current_bonus_speed = 0;
-
-        // create the shields
-        int num_shields = 0;
-        memset(shields, 0, NUM_SHIELDS * sizeof(shields[0]));
-        for (int j = 0; j < NUM_SHIELD_GROUPS; ++j) {
-            for (int k = 0; k < SHIELD_GROUP_HEIGHT; ++k) {
-                for (int i = 0; i < SHIELD_GROUP_WIDTH; ++i) {
-                    ShieldPiece& shield = shields[num_shields++];
-                    //shields[num_shields++].ShieldPiece_init(x, y, 0, 0, true);
-                    shield.intact = true;
-                    if ((k == 0) && (i == 0 || i == SHIELD_GROUP_WIDTH - 1))
-                        shield.intact = false;
-                    shield.group = j;
-                    shield.x = i;
-                    shield.y = k;
-
-                    shield_group_tiles[j].update_shield_piece(shield);
-                }
-            }
-
-            shield_groups[j].init(GAME_ENTITY_SHIELD_GROUP, j,
-                                  j * SHIELD_GROUP_X_SPACING + SHIELD_X_OFFSET,
-                                  SHIELD_Y_OFFSET, true);
-        }
         for (int type = 0; type < NUM_GAME_ENTITY_TYPES; ++type) {
             GameEntities::GameEntityTypeProperties prop;
             memset(&prop, 0, sizeof(prop));
@@ -328,7 +304,7 @@ namespace Game {
                 prop.images[4] = 2;
                 prop.images[5] = 1;
 
-                prop.points = 25;
+                prop.points = BCD_CONSTANT(25);
                 prop.frame_duration = 225;
                 prop.right_limit = screen_w - ALIEN_WIDTH;
                 prop.bottom_limit = player_top - ALIEN_HEIGHT / 3;
@@ -348,7 +324,7 @@ namespace Game {
                 prop.images[4] = 2;
                 prop.images[5] = 1;
 
-                prop.points = 50;
+                prop.points = BCD_CONSTANT(50);
                 prop.frame_duration = 225;
                 prop.right_limit = screen_w - ALIEN_WIDTH;
                 prop.bottom_limit = player_top - ALIEN_HEIGHT / 3;
@@ -368,7 +344,7 @@ namespace Game {
                 prop.images[4] = 2;
                 prop.images[5] = 1;
 
-                prop.points = 100;
+                prop.points = BCD_CONSTANT(100);
                 prop.frame_duration = 225;
                 prop.right_limit = screen_w - ALIEN_WIDTH;
                 prop.bottom_limit = player_top - ALIEN_HEIGHT / 3;
@@ -385,7 +361,7 @@ namespace Game {
                 prop.images[0] = 0;
                 prop.images[1] = 1;
 
-                prop.points = 1000;
+                prop.points = BCD_CONSTANT(1000);
                 prop.frame_duration = 55;
                 prop.w = BONUS_SHIP_WIDTH;
                 prop.coll_w = int (BONUS_SHIP_WIDTH * 0.9);
@@ -398,7 +374,7 @@ namespace Game {
                 prop.images[0] = 0;
                 prop.images[1] = 1;
 
-                prop.points = 5000;
+                prop.points = BCD_CONSTANT(5000);
                 prop.frame_duration = 55;
                 prop.w = SMALL_BONUS_SHIP_WIDTH;
                 prop.coll_w = int (SMALL_BONUS_SHIP_WIDTH * 0.9);
@@ -474,6 +450,120 @@ namespace Game {
         generate_starfield(&screen, STARFIELD2_LAYER_INDEX, 2,
                            SCREEN_TILE_SIZE, SCREEN_TILE_SIZE,
                            NUM_STARFIELD_TILES, STARFIELD_DENSITY, 16, 64);
+
+        // Set up tile layer for text and the status display on it.
+        font.init(FONT_PALETTE_INDEX, g_font_vram_offset);
+        status.reset();
+    }
+    void Game::init_wave()
+    {
+        // create conditions for next wave
+        logic_this_loop = wave_over = false;
+        last_shot = 0;
+        player_shot_counter = alien_shot_counter = explosion_counter = 0;
+#ifdef EVENT_COUNTER
+        event_counter.new_wave(wave + 1);
+#endif
+#ifdef LATENCY_MONITOR
+        latency_monitor.new_wave(wave + 1);
+#endif
+        factory();
+        redraw_formation = ALL_ALIEN_PARITIES;
+        ++wave;
+        // output wave message and status display
+        char message[MESSAGE_WIDTH + 1];
+        sprintf(message, "WAVE %d", wave);
+        show_message(message, false);
+        status.set_wave(wave);
+        status.set_score(score);
+        status.set_lives(player_life);
+        status.draw();
+        sound.play(Sound::START_WAVE);
+        screen.update();
+        System::delay(WAVE_MESSAGE_TIME);
+        font.clear_text(0, MESSAGE_ROW, MESSAGE_WIDTH);
+    }
+    void Game::init_aliens(int rand_max)
+    {
+        // Keep count of both the total number of aliens and the number of each
+        // type of alien.
+        alien_count = 0;
+        uint8_t alien_type_counts[NUM_GAME_ENTITY_TYPES];
+        memset(alien_type_counts, 0, sizeof(alien_type_counts));
+        // Create a formation of aliens.
+        for (int row = 0; row < ALIEN_ARRAY_HEIGHT; ++row) {
+            int type = get_alien_type_by_row(row);
+            for (int col = 0; col < ALIEN_ARRAY_WIDTH; ++col) {
+                // Populate the alien count for each column.  This is redundant
+                // because it goes through the same initialization
+                // |ALIEN_ARRAY_HEIGHT| times, but it saves code space by not
+                // having a separate for loop from 0 to |ALIEN_ARRAY_WIDTH - 1|.
+                num_aliens_per_col[col] = ALIEN_ARRAY_HEIGHT;
+
+                // initialize the bottom row of aliens to fire
+                bool active = (row == ALIEN_ARRAY_HEIGHT - 1);
+                int index = alien_type_counts[type]++;
+
+                // Instantiate an alien.
+                Alien temp_alien;
+                temp_alien.Alien_init(type, index, ALIEN_BASE_X, ALIEN_BASE_Y,
+                                      active, rand() % (rand_max + 1));
+
+                // Convert it to a reduced alien.
+                ReducedAlien& alien = aliens[alien_count];
+                alien.alive = temp_alien.is_alive();
+                alien.active = temp_alien.is_active();
+                alien.dirty = temp_alien.is_dirty();
+                alien.fire_chance = temp_alien.get_fire_chance();
+                alien.row = row;
+                alien.col = col;
+
+                // If this is the first alien, save it as a reference.
+                if (alien_count == 0) {
+                  *reference_alien = temp_alien;
+                }
+                ++alien_count;
+            }
+        }
+        // create alien shots
+        for (int i = 0; i < num_alien_shots; ++i) {
+            alien_shots[i].Shot_init(num_player_shots + i, 0, 0, false);
+        }
+    }
+    void Game::factory()
+    {
+        // create the player ship and place it in the center of the screen
+        player->Player_init(player_center, player_top, true);
+        current_player_speed = 0;
+
+        // create bonus ship and small bonus ship
+        bonus->BonusShip_init(false, 0, 0, false);
+        sbonus->BonusShip_init(true, 0, 0, false);
+        current_bonus_speed = 0;
+
+        // create the shields
+        int num_shields = 0;
+        memset(shields, 0, NUM_SHIELDS * sizeof(shields[0]));
+        for (int j = 0; j < NUM_SHIELD_GROUPS; ++j) {
+            for (int k = 0; k < SHIELD_GROUP_HEIGHT; ++k) {
+                for (int i = 0; i < SHIELD_GROUP_WIDTH; ++i) {
+                    ShieldPiece& shield = shields[num_shields++];
+                    //shields[num_shields++].ShieldPiece_init(x, y, 0, 0, true);
+                    shield.intact = true;
+                    if ((k == 0) && (i == 0 || i == SHIELD_GROUP_WIDTH - 1))
+                        shield.intact = false;
+                    shield.group = j;
+                    shield.x = i;
+                    shield.y = k;
+
+                    shield_tiles->update_shield_piece(shield);
+                }
+            }
+
+            shield_groups[j].init(GAME_ENTITY_SHIELD_GROUP, j,
+                                  j * SHIELD_GROUP_X_SPACING + SHIELD_X_OFFSET,
+                                  SHIELD_Y_OFFSET, true);
+        }
         starfield_y_offset = 0;
         screen.scroll_tile_layer(STARFIELD_LAYER_INDEX, 0, 0);
         screen.scroll_tile_layer(STARFIELD2_LAYER_INDEX, 0, 0);
@@ -488,35 +578,20 @@ namespace Game {
 
         player_shot_delay = 225;
         bonus_launch_delay = base_launch_delay;
-        int array_select;
         // increase difficulty and chance for bonus points as waves progress
-        if (wave < 6) {
-            alien_shot_delay = 400 - wave * 25;
-            num_alien_shots = 16 + wave;
-
-            current_alien_speed +=
-                INT_TO_FIXED(ALIEN_BASE_SPEED) +
-                wave * INT_TO_FIXED(ALIEN_WAVE_SPEED_INCREASE);
-
-            array_select = wave;
-        } else {  // if (wave >= 6)
-            if (alien_shot_delay > 200) {
-                alien_shot_delay -= 20;
-                num_alien_shots += 3;
-                if (num_alien_shots > MAX_NUM_ALIEN_SHOTS)
-                    num_alien_shots = MAX_NUM_ALIEN_SHOTS;
-            }
-            current_alien_speed += INT_TO_FIXED(ALIEN_HIGH_WAVE_SPEED_INCREASE);
-            array_select = 6;
-        }
-        const uint8_t kAlienOddRangeValues[] = {10, 9, 8, 8, 7, 6, 6};
-        const uint8_t kBonusSelectMax[] = {5, 5, 4, 4, 3, 2, 2};
-        const uint8_t kLaunchDelayMax[] = {4, 4, 3, 3, 3, 3, 2};
-        alien_odd_range = kAlienOddRangeValues[array_select];
+        WaveDifficulty difficulty;
+        memcpy_P(&difficulty, &kWaveDifficulty[get_difficulty_wave(wave)],
+                 sizeof(difficulty));
+        alien_shot_delay = difficulty.alien_shot_delay;
+        num_alien_shots = difficulty.num_alien_shots;
+        alien_odd_range = difficulty.alien_odd_range;
+        current_alien_speed = get_alien_speed(wave, NUM_ALIENS);
         for (int i = 0; i < random_list_len; ++i) {
             direction[i] = (rand() % 3);
-            bonus_select[i] = (rand() % (kBonusSelectMax[array_select] + 1));
-            launch_delay[i] = (rand() % (kLaunchDelayMax[array_select] + 1));
+            bonus_select[i] =
+                (rand() % (difficulty.bonus_select_max + 1));
+            launch_delay[i] =
+                (rand() % (difficulty.launch_delay_max + 1));
         }
         init_aliens(alien_odd_range);
 #ifdef FRAME_COUNTER
@@ -525,22 +600,24 @@ namespace Game {
     }
     void Game::game_loop()
     {
-        System::KeyState keys;
-        int reloading = 0;
         last_bonus_launch = last_alien_shot = last_loop_time = System::get_ticks();
+        System::clear_key_events();
+        // Bit N is set if System::Key N is down.
+        uint8_t keys = System::get_polled_keys();
 
+        update_march();
 #ifdef EVENT_COUNTER
         event_counter.reset();
 #endif
+        frame_budget.reset();
         while (1) {
+            ++num_frames;
             // used to calculate how far the entities should move this loop
             // delta is the number of milliseconds the last loop iteration took
             // movement is a function of delta
             delta = System::get_ticks() - last_loop_time;
             last_loop_time = System::get_ticks();
-
-            // background track
-            //sound.play_bg(alien_count);
+            frame_budget.start_work();
 
 #ifdef FRAME_COUNTER
             // frame counter
@@ -556,33 +633,52 @@ namespace Game {
             }
 #endif
 
-            // poll input queue
-            keys = System::get_key_state();
-            if (keys.quit) {
-                //sound.halt_all_sounds();
-                player_dead = true;
-                player_life = 0;
-                return;
-            }
-            if (keys.pause) {
-                pause();
-            }
-
-            // player attempt to fire
-            if (!reloading) {
-                if (keys.fire) {
-                    fire_shot();
+            // poll input queue.  Handle the key presses in the order they
+            // happened, even if several came in during one loop.
+            System::poll_keys();
+            System::KeyEvent event;
+            while (System::get_key_event(&event)) {
+#ifdef LATENCY_MONITOR
+                if (event.key == System::KEY_LEFT ||
+                    event.key == System::KEY_RIGHT) {
+                    if (event.pressed)
+                        latency_monitor.start(LATENCY_MOVE, event.time);
+                    else
+                        latency_monitor.cancel(LATENCY_MOVE);
+                }
+#endif
+                if (!event.pressed) {
+                    keys &= ~(1 << event.key);
+                    continue;
+                }
+                keys |= (1 << event.key);
+                if (event.key == System::KEY_QUIT) {
+                    sound.halt_all();
+                    player_dead = true;
+                    player_life = 0;
+                    return;
+                }
+                if (event.key == System::KEY_PAUSE) {
+                    pause();
+                    // Drop whatever was pressed during the pause.
+                    System::clear_key_events();
+                    keys = System::get_polled_keys();
+                    // Don't count the pause against the frame budget.
+                    frame_budget.start_work();
                 }
+                // player attempt to fire
+                if (event.key == System::KEY_FIRE)
+                    fire_shot(event.time);
             }
-            reloading = keys.fire;
-
 
             // set player direction based on key input
+            bool left = keys & (1 << System::KEY_LEFT);
+            bool right = keys & (1 << System::KEY_RIGHT);
             current_player_speed = 0;
-            if (keys.left && !keys.right) {
+            if (left && !right) {
                 current_player_speed = -player_speed;
             }
-            if (keys.right && !keys.left) {
+            if (right && !left) {
                 current_player_speed = player_speed;
             }
 
@@ -594,407 +690,478 @@ namespace Game {
             launch_bonus_ship();
 #ifdef EVENT_COUNTER
         event_counter.end_game_logic_section(0);
-
-        event_counter.start_game_logic_section(1);
 #endif
-            // move everything
-            if (player->is_active())
-                player->movement(delta, current_player_speed);
-            if (bonus->is_active()) {
-                //sound.play_bonus();
-                bonus->movement(delta, current_bonus_speed);
-            } else {
-                //sound.halt_bonus();
-            }
-            // Cast |delta| to a signed value to correctly multiply.  Otherwise
-            // the result is incorrect due to mixing signed and unsigned ints
-            // with different widths.
-            fixed alien_movement =
-                (current_alien_speed * (int32_t)delta) / 1000;
-            // All the aliens move in tandem so just update the reference alien.
-            reference_alien->movement(delta, alien_movement);
-            // Now find an alien on each edge of the formation and use it for
-            // edge collision detection.
-            int8_t left_col, right_col;
-            for (left_col = 0; left_col < ALIEN_ARRAY_WIDTH; ++left_col) {
-              if (num_aliens_per_col[left_col] > 0)
-                break;
-            }
-            for (right_col = ALIEN_ARRAY_WIDTH - 1; right_col >= 0;
-                 --right_col) {
-              if (num_aliens_per_col[right_col] > 0)
-                break;
-            }
-            // Move these edge aliens and test edge collision.
-            uint8_t num_aliens_to_test = (left_col == right_col) ? 1 : 2;
-            uint8_t alien_cols[] = { left_col, right_col };
-            for (uint8_t index = 0; index < num_aliens_to_test; ++index) {
-                uint8_t offset;
-                for (uint8_t row = 0, offset = 0;
-                     row < ALIEN_ARRAY_HEIGHT;
-                     ++row, offset += ALIEN_ARRAY_WIDTH) {
-                  if (aliens[offset + alien_cols[index]].is_alive()) {
-                    Alien alien;
-                    make_alien(aliens[offset + alien_cols[index]],
-                               reference_alien, &alien);
-                    alien.movement(delta, alien_movement);
-                    break;
-                  }
-                }
+            move_entities();
+            handle_collisions();
+
+            // the conditions to break out of the game loop
+            // the order of these matters
+            if (aliens_landed) {
+                sound.halt(Sound::ACTIVE_BONUS);
+                halt_background_sounds();
+                sound.wait_for_all_to_finish();
+                sound.play(Sound::ALIENS_LANDED);
+                show_message(PSTR("GAME OVER"), true);
+                sound.play(Sound::GAME_OVER);
+                //ui.check_high_scores(score, wave);
+                return;
             }
-#ifdef EVENT_COUNTER
-        event_counter.end_game_logic_section(1);
-        event_counter.start_game_logic_section(2);
-#endif
-            for (int i = 0; i < num_player_shots; ++i) {
-                if (player_shots[i].is_active()) {
-                    player_shots[i].movement(delta, shot_speed);
+            // conditions for player death by alien shot or collision
+            if (player_dead && no_explosions_active()) {
+                --player_life;
+                status.set_lives(player_life);
+                sound.halt(Sound::ACTIVE_BONUS);
+                halt_background_sounds();
+                if (!player_life) {
+                    sound.play(Sound::PLAYER_DEAD);
+                    sound.wait_for_all_to_finish();
+                    show_message(PSTR("GAME OVER"), true);
+                    sound.play(Sound::GAME_OVER);
+                    //ui.check_high_scores(score, wave);
+                    return;
                 }
-            }
-            for (int i = 0; i < num_alien_shots; ++i) {
-                if (alien_shots[i].is_active()) {
-                    alien_shots[i].movement(delta, alien_shot_speed);
+                dead_pause = System::get_ticks();
+                sound.play(Sound::PLAYER_DEAD);
+                player_rebirth();
+                frame_budget.start_work();
+                if (bonus->is_active())
+                    sound.play_loop(Sound::ACTIVE_BONUS);
+                update_march();
+                last_loop_time += System::get_ticks() - dead_pause;
+                last_bonus_launch = last_alien_shot = System::get_ticks();
+                // erase player and alien shots to give player a chance to continue
+                for (int i = 0; i < num_alien_shots; ++i) {
+                    alien_shots[i].deactivate();
                 }
-            }
-            // explosion duration
-            for (int i = 0; i < num_explosions; ++i) {
-                if (explosions[i].is_active()) {
-                    explosions[i].duration(delta, 0);
+                for (int i = 0; i < num_player_shots; ++i) {
+                    player_shots[i].deactivate();
+                }
+                player_dead = false;
+            }
+            // conditions for end of wave
+            if (wave_over && !bonus->is_active()) {
+                bonus_launch_delay = 100000;
+                player_shot_delay = 100000;
+                // wait for explosions and shots to finish
+                if (no_explosions_active() && no_player_shots_active() && no_alien_shots_active()) {
+                    wave_cleanup();
+                    sound.wait_for_all_to_finish();
+                    sound.play(Sound::END_WAVE);
+                    return;
                 }
             }
 
-            // Move starfields.
-            starfield_y_offset += INT_TO_FIXED(delta * STARFIELD_SPEED) / 1000;
-#ifdef EVENT_COUNTER
-        event_counter.end_game_logic_section(2);
-        event_counter.start_game_logic_section(3);
-#endif
-
-            // collision handling
+            // run alien logic if neccessary
+            if (logic_this_loop) {
+                current_alien_speed = -current_alien_speed;
+                reference_alien->do_alien_logic();
+                logic_this_loop = false;
+            }
+
+            // draw everything
+            unmixed_sound_time += delta;
+            frame_budget.end_work();
+            screen.begin_update();
+            frame_budget.start_work();
+            draw_entities();
+            // Mix whatever the wait for the display did not get to.
+            sound.update(unmixed_sound_time);
+            unmixed_sound_time = 0;
+            frame_budget.end_work();
+            screen.update();
+            frame_budget.end_frame();
 
-            // alien shots with player and shields
-            for (int i = 0; i < num_alien_shots; ++i) {
-                Shot* shot = &alien_shots[i];
+#ifdef EVENT_COUNTER
+            event_counter.new_loop();
+#endif
+        }
+    }
+    void Game::move_entities()
+    {
+#ifdef EVENT_COUNTER
+        event_counter.start_game_logic_section(1);
+#endif
+        // move everything
+        if (player->is_active())
+            player->movement(delta, current_player_speed);
+        if (bonus->is_active()) {
+            bonus->movement(delta, current_bonus_speed);
+            // The bonus ship sound was started by launch_bonus_ship().  Only
+            // send a command when the ship leaves the screen, so the mixer's
+            // command queue does not fill up with one every frame.
+            if (!bonus->is_active())
+                sound.halt(Sound::ACTIVE_BONUS);
+        }
+        // Cast |delta| to a signed value to correctly multiply.  Otherwise
+        // the result is incorrect due to mixing signed and unsigned ints
+        // with different widths.
+        fixed alien_movement =
+            (current_alien_speed * (int32_t)delta) / 1000;
+        // All the aliens move in tandem so just update the reference alien.
+        reference_alien->movement(delta, alien_movement);
+        // Now find an alien on each edge of the formation and use it for
+        // edge collision detection.
+        int8_t left_col, right_col;
+        for (left_col = 0; left_col < ALIEN_ARRAY_WIDTH; ++left_col) {
+          if (num_aliens_per_col[left_col] > 0)
+            break;
+        }
+        for (right_col = ALIEN_ARRAY_WIDTH - 1; right_col >= 0;
+             --right_col) {
+          if (num_aliens_per_col[right_col] > 0)
+            break;
+        }
+        // Move these edge aliens and test edge collision.
+        uint8_t num_aliens_to_test = (left_col == right_col) ? 1 : 2;
+        uint8_t alien_cols[] = { left_col, right_col };
+        for (uint8_t index = 0; index < num_aliens_to_test; ++index) {
+            uint8_t offset;
+            for (uint8_t row = 0, offset = 0;
+                 row < ALIEN_ARRAY_HEIGHT;
+                 ++row, offset += ALIEN_ARRAY_WIDTH) {
+              if (aliens[offset + alien_cols[index]].is_alive()) {
+                Alien alien;
+                make_alien(aliens[offset + alien_cols[index]],
+                           reference_alien, &alien);
+                alien.movement(delta, alien_movement);
+                break;
+              }
+            }
+        }
+#ifdef EVENT_COUNTER
+        event_counter.end_game_logic_section(1);
+        event_counter.start_game_logic_section(2);
+#endif
+        for (int i = 0; i < num_player_shots; ++i) {
+            if (player_shots[i].is_active()) {
+                player_shots[i].movement(delta, shot_speed);
+            }
+        }
+        for (int i = 0; i < num_alien_shots; ++i) {
+            if (alien_shots[i].is_active()) {
+                alien_shots[i].movement(delta, alien_shot_speed);
+            }
+        }
+        // explosion duration
+        for (int i = 0; i < num_explosions; ++i) {
+            if (explosions[i].is_active()) {
+                explosions[i].duration(delta, 0);
+            }
+        }
+
+        // Move starfields.
+        starfield_y_offset += INT_TO_FIXED(delta * STARFIELD_SPEED) / 1000;
+#ifdef EVENT_COUNTER
+        event_counter.end_game_logic_section(2);
+#endif
+    }
+    void Game::handle_collisions()
+    {
+#ifdef EVENT_COUNTER
+        event_counter.start_game_logic_section(3);
+#endif
+        // collision handling
+
+        // alien shots with player and shields
+        for (int i = 0; i < num_alien_shots; ++i) {
+            Shot* shot = &alien_shots[i];
+            if (!shot->is_active())
+                continue;
+
+            if (player->collides_with(shot)) {
+                player->player_shot_collision(shot);
                 if (!shot->is_active())
                     continue;
+            }
+            uint8_t group;
+            if (!collides_with_shield_group(shot, &group))
+                continue;
 
-                if (player->collides_with(shot)) {
-                    player->player_shot_collision(shot);
+            for (int i = group * NUM_SHIELDS_PER_GROUP;
+                 i < (group + 1) * NUM_SHIELDS_PER_GROUP && i < NUM_SHIELDS;
+                 ++i) {
+                //ShieldPiece* shield = &shields[i];
+                if (!shields[i].intact)
+                  continue;
+                GameEntity shield;
+                make_shield(shields[i], &shield);
+                if (shield.is_alive() && shield.collides_with(shot)) {
+                    shot->shot_shield_collision(&shield);
+                    shields[i].intact = false;
+                    shield_tiles->update_shield_piece(shields[i]);
                     if (!shot->is_active())
-                        continue;
-                }
-                uint8_t group;
-                if (!collides_with_shield_group(shot, &group))
-                    continue;
-
-                for (int i = group * NUM_SHIELDS_PER_GROUP;
-                     i < (group + 1) * NUM_SHIELDS_PER_GROUP && i < NUM_SHIELDS;
-                     ++i) {
-                    //ShieldPiece* shield = &shields[i];
-                    if (!shields[i].intact)
-                      continue;
-                    GameEntity shield;
-                    make_shield(shields[i], &shield);
-                    if (shield.is_alive() && shield.collides_with(shot)) {
-                        shot->shot_shield_collision(&shield);
-                        shields[i].intact = false;
-                        shield_group_tiles[shields[i].group].
-                                update_shield_piece(shields[i]);
-                        if (!shot->is_active())
-                            break;
-                    }
+                        break;
                 }
             }
+        }
 #ifdef EVENT_COUNTER
         event_counter.end_game_logic_section(3);
         event_counter.start_game_logic_section(4);
 #endif
-            // shots with shots
-            for (int j = 0; j < num_player_shots; ++j) {
-                Shot* shot = &player_shots[j];
-                if (!shot->is_active())
-                    continue;
+        // shots with shots
+        for (int j = 0; j < num_player_shots; ++j) {
+            Shot* shot = &player_shots[j];
+            if (!shot->is_active())
+                continue;
 
-                  for (int i = 0; i < num_alien_shots; ++i) {
-                      Shot* alien_shot = &alien_shots[i];
-                      if (!alien_shot->is_active())
-                          continue;
-                      if (shot->collides_with(alien_shot)) {
-                          //sound.play_shot_collision();
-                          shot->shot_shot_collision(alien_shot);
-                          if (!shot->is_active())
-                              break;
-                      }
+              for (int i = 0; i < num_alien_shots; ++i) {
+                  Shot* alien_shot = &alien_shots[i];
+                  if (!alien_shot->is_active())
+                      continue;
+                  if (shot->collides_with(alien_shot)) {
+                      sound.play(Sound::SHOT_COLLISION);
+                      shot->shot_shot_collision(alien_shot);
+                      if (!shot->is_active())
+                          break;
                   }
-            }
+              }
+        }
 #ifdef EVENT_COUNTER
         event_counter.end_game_logic_section(4);
         event_counter.start_game_logic_section(5);
 #endif
-            // player shots with aliens, bonus, and shields
-            for (int j = 0; j < num_player_shots; ++j) {
-                Shot* shot = &player_shots[j];
+        // player shots with aliens, bonus, and shields
+        for (int j = 0; j < num_player_shots; ++j) {
+            Shot* shot = &player_shots[j];
+            if (!shot->is_active())
+                continue;
+            if (bonus->is_active() && shot->collides_with(bonus)) {
+                bonus->bonus_shot_collision(shot);
                 if (!shot->is_active())
-                    continue;
-                if (bonus->is_active() && shot->collides_with(bonus)) {
-                    bonus->bonus_shot_collision(shot);
+                    break;
+            }
+            if (!shot->is_active())
+                continue;
+            // TODO: Should be able to check only nearby aliens using array.
+            for (int i = 0; i < NUM_ALIENS; ++i) {
+                if (!aliens[i].is_alive())
+                  continue;
+                // Construct full alien from reduced alien for collision
+                // testing.
+                Alien temp_alien;
+                make_alien(aliens[i], reference_alien, &temp_alien);
+                if (shot->collides_with(&temp_alien)) {
+                    shot->shot_alien_collision(&temp_alien);
+                    // Update the reduced alien.
+                    aliens[i].active = temp_alien.is_active();
+                    aliens[i].dirty = temp_alien.is_dirty();
+                    if (!temp_alien.is_alive()) {
+                      aliens[i].alive = false;
+                      --num_aliens_per_col[aliens[i].col];
+                    }
                     if (!shot->is_active())
                         break;
                 }
-                if (!shot->is_active())
-                    continue;
-                // TODO: Should be able to check only nearby aliens using array.
-                for (int i = 0; i < NUM_ALIENS; ++i) {
-                    if (!aliens[i].is_alive())
-                      continue;
-                    // Construct full alien from reduced alien for collision
-                    // testing.
-                    Alien temp_alien;
-                    make_alien(aliens[i], reference_alien, &temp_alien);
-                    if (shot->collides_with(&temp_alien)) {
-                        shot->shot_alien_collision(&temp_alien);
-                        // Update the reduced alien.
-                        aliens[i].active = temp_alien.is_active();
-                        aliens[i].dirty = temp_alien.is_dirty();
-                        if (!temp_alien.is_alive()) {
-                          aliens[i].alive = false;
-                          --num_aliens_per_col[aliens[i].col];
-                        }
-                        if (!shot->is_active())
-                            break;
-                    }
-                }
-                if (!shot->is_active())
-                    continue;
-                uint8_t group;
-                if (!collides_with_shield_group(shot, &group))
-                    continue;
-                for (int i = group * NUM_SHIELDS_PER_GROUP;
-                     i < (group + 1) * NUM_SHIELDS_PER_GROUP && i < NUM_SHIELDS;
-                     ++i) {
-                    if (!shields[i].intact)
-                      continue;
-                    GameEntity shield;
-                    make_shield(shields[i], &shield);
-                    if (shield.is_alive() && shield.collides_with(shot)) {
-                        shot->shot_shield_collision(&shield);
-                        shields[i].intact = false;
-                        shield_group_tiles[shields[i].group].
-                                update_shield_piece(shields[i]);
-                        if (!shot->is_active())
-                            break;
-                    }
+            }
+            if (!shot->is_active())
+                continue;
+            uint8_t group;
+            if (!collides_with_shield_group(shot, &group))
+                continue;
+            for (int i = group * NUM_SHIELDS_PER_GROUP;
+                 i < (group + 1) * NUM_SHIELDS_PER_GROUP && i < NUM_SHIELDS;
+                 ++i) {
+                if (!shields[i].intact)
+                  continue;
+                GameEntity shield;
+                make_shield(shields[i], &shield);
+                if (shield.is_alive() && shield.collides_with(shot)) {
+                    shot->shot_shield_collision(&shield);
+                    shields[i].intact = false;
+                    shield_tiles->update_shield_piece(shields[i]);
+                    if (!shot->is_active())
+                        break;
                 }
             }
+        }
 #ifdef EVENT_COUNTER
         event_counter.end_game_logic_section(5);
         event_counter.start_game_logic_section(6);
 #endif
-            // Aliens with shields.
-            for (int k = 0; k < ALIEN_ARRAY_HEIGHT; ++k) {
-                uint8_t alien_index = k * ALIEN_ARRAY_WIDTH;
-                for (int j = 0; j < ALIEN_ARRAY_WIDTH; ++j, ++alien_index) {
-                    if (!aliens[alien_index].is_alive())
-                        continue;
-
-                    Alien temp_alien;
-                    make_alien(aliens[alien_index], reference_alien,
-                               &temp_alien);
-                    Alien* alien = &temp_alien;
-
-                    // If the alien is higher than the shield groups, so are all
-                    // other aliens in the row, so skip the rest of the row.
-                    if (alien->get_y() + alien->get_h() < SHIELD_Y_OFFSET)
-                        break;
+        // Aliens with shields.
+        for (int k = 0; k < ALIEN_ARRAY_HEIGHT; ++k) {
+            uint8_t alien_index = k * ALIEN_ARRAY_WIDTH;
+            for (int j = 0; j < ALIEN_ARRAY_WIDTH; ++j, ++alien_index) {
+                if (!aliens[alien_index].is_alive())
+                    continue;
+
+                Alien temp_alien;
+                make_alien(aliens[alien_index], reference_alien,
+                           &temp_alien);
+                Alien* alien = &temp_alien;
+
+                // If the alien is higher than the shield groups, so are all
+                // other aliens in the row, so skip the rest of the row.
+                if (alien->get_y() + alien->get_h() < SHIELD_Y_OFFSET)
+                    break;
+
+                uint8_t group;
+                if (!collides_with_shield_group(alien, &group))
+                    continue;
 
-                    uint8_t group;
-                    if (!collides_with_shield_group(alien, &group))
-                        continue;
-
-                    // Compute the alien collision edges, relative to the upper
-                    // left corner of the shield group.
-                    int alien_left = alien->get_x() + alien->coll_x_offset() -
-                            shield_groups[group].get_x();
-                    int alien_right = alien_left + alien->coll_w() - 1;
-                    int alien_top = alien->get_y() + alien->coll_y_offset() -
-                            shield_groups[group].get_y();
-                    int alien_bottom = alien_top + alien->coll_h() - 1;
-
-                    // Now compute the range of shield pieces within the group
-                    // that are touching the alien.
-                    int shield_left = max(alien_left / SHIELD_PIECE_SIZE, 0);
-                    int shield_right = min(alien_right / SHIELD_PIECE_SIZE,
-                                           SHIELD_GROUP_WIDTH - 1);
-                    int shield_top = max(alien_top / SHIELD_PIECE_SIZE, 0);
-                    int shield_bottom = min(alien_bottom / SHIELD_PIECE_SIZE,
-                                            SHIELD_GROUP_HEIGHT - 1);
-
-                    uint8_t offset = group * NUM_SHIELDS_PER_GROUP +
-                                     shield_top * SHIELD_GROUP_WIDTH;
-                    for (int y = shield_top; y <= shield_bottom;
-                         ++y, offset += SHIELD_GROUP_WIDTH) {
-                        for (int x = shield_left; x <= shield_right; ++x) {
-                            if (!shields[offset + x].intact)
-                                continue;
-                            // Break all pieces that are still intact.  The
-                            // alien survives.
-                            shields[offset + x].intact = false;
-                            shield_group_tiles[group].
-                                    update_shield_piece(shields[offset + x]);
-                        }
+                // Compute the alien collision edges, relative to the upper
+                // left corner of the shield group.
+                int alien_left = alien->get_x() + alien->coll_x_offset() -
+                        shield_groups[group].get_x();
+                int alien_right = alien_left + alien->coll_w() - 1;
+                int alien_top = alien->get_y() + alien->coll_y_offset() -
+                        shield_groups[group].get_y();
+                int alien_bottom = alien_top + alien->coll_h() - 1;
+
+                // Now compute the range of shield pieces within the group
+                // that are touching the alien.
+                int shield_left = max(alien_left / SHIELD_PIECE_SIZE, 0);
+                int shield_right = min(alien_right / SHIELD_PIECE_SIZE,
+                                       SHIELD_GROUP_WIDTH - 1);
+                int shield_top = max(alien_top / SHIELD_PIECE_SIZE, 0);
+                int shield_bottom = min(alien_bottom / SHIELD_PIECE_SIZE,
+                                        SHIELD_GROUP_HEIGHT - 1);
+
+                uint8_t offset = group * NUM_SHIELDS_PER_GROUP +
+                                 shield_top * SHIELD_GROUP_WIDTH;
+                for (int y = shield_top; y <= shield_bottom;
+                     ++y, offset += SHIELD_GROUP_WIDTH) {
+                    for (int x = shield_left; x <= shield_right; ++x) {
+                        if (!shields[offset + x].intact)
+                            continue;
+                        // Break all pieces that are still intact.  The
+                        // alien survives.
+                        shields[offset + x].intact = false;
+                        shield_tiles->update_shield_piece(shields[offset + x]);
                     }
                 }
             }
-            // Aliens with player.
-            for (int k = 0; k < ALIEN_ARRAY_HEIGHT && player->is_active(); ++k) {
-                uint8_t alien_index = k * ALIEN_ARRAY_WIDTH;
-                for (int j = 0; j < ALIEN_ARRAY_WIDTH; ++j, ++alien_index) {
-                    ReducedAlien& reduced_alien = aliens[alien_index];
-                    if (!reduced_alien.is_alive())
-                        continue;
-                    Alien alien;
-                    make_alien(reduced_alien, reference_alien, &alien);
-                    // If the alien doesn't overlap with the player along the
-                    // vertical axis, skip the entire row of aliens.
-                    if (alien.get_y() + alien.get_h() < player->get_y() ||
-                        alien.get_y() > player->get_y() + player->get_w()) {
+        }
+        // Aliens with player.
+        for (int k = 0; k < ALIEN_ARRAY_HEIGHT && player->is_active(); ++k) {
+            uint8_t alien_index = k * ALIEN_ARRAY_WIDTH;
+            for (int j = 0; j < ALIEN_ARRAY_WIDTH; ++j, ++alien_index) {
+                ReducedAlien& reduced_alien = aliens[alien_index];
+                if (!reduced_alien.is_alive())
+                    continue;
+                Alien alien;
+                make_alien(reduced_alien, reference_alien, &alien);
+                // If the alien doesn't overlap with the player along the
+                // vertical axis, skip the entire row of aliens.
+                if (alien.get_y() + alien.get_h() < player->get_y() ||
+                    alien.get_y() > player->get_y() + player->get_w()) {
+                    break;
+                }
+                if (player->collides_with(&alien)) {
+                    player->player_alien_collision(&alien);
+                    if (!player->is_alive())
                         break;
+                    if (!alien.is_alive()) {
+                      reduced_alien.alive = false;
+                      --num_aliens_per_col[reduced_alien.col];
                     }
-                    if (player->collides_with(&alien)) {
-                        player->player_alien_collision(&alien);
-                        if (!player->is_alive())
-                            break;
-                        if (!alien.is_alive()) {
-                          reduced_alien.alive = false;
-                          --num_aliens_per_col[reduced_alien.col];
-                        }
-                        reduced_alien.dirty = alien.is_dirty();
-                    }
+                    reduced_alien.dirty = alien.is_dirty();
                 }
             }
+        }
 #ifdef EVENT_COUNTER
         event_counter.end_game_logic_section(6);
 #endif
-
-            // the conditions to break out of the game loop
-            // the order of these matters
-            if (aliens_landed) {
-                //sound.halt_bonus();
-                //sound.halt_all_bg();
-                //sound.wait_for_all_to_finish();
-                //sound.play_aliens_landed();
-                //ui.screen_msg("Game Over");
-                //sound.play_game_over();
-                //ui.check_high_scores(score, wave);
-                return;
-            }
-            // conditions for player death by alien shot or collision
-            if (player_dead && no_explosions_active()) {
-                --player_life;
-                //status.blit_lives(player_life);
-                //sound.halt_bonus();
-                //sound.halt_all_bg();
-                if (!player_life) {
-                    //sound.halt_all_bg();
-                    //sound.play_player_dead();
-                    //sound.wait_for_all_to_finish();
-                    //ui.screen_msg("Game Over");
-                    //sound.play_game_over();
-                    //ui.check_high_scores(score, wave);
-                    return;
-                }
-                dead_pause = System::get_ticks();
-                //sound.play_player_dead();
-                //status.erase_player_ship(player_life, images.get_image_index("ship.png"));
-                player_rebirth();
-                //sound.play_bonus();
-                //sound.play_bg(alien_count);
-                last_loop_time += System::get_ticks() - dead_pause;
-                last_bonus_launch = last_alien_shot = System::get_ticks();
-                // erase player and alien shots to give player a chance to continue
-                for (int i = 0; i < num_alien_shots; ++i) {
-                    alien_shots[i].deactivate();
-                }
-                for (int i = 0; i < num_player_shots; ++i) {
-                    player_shots[i].deactivate();
-                }
-                player_dead = false;
-            }
-            // conditions for end of wave
-            //if (wave_over) sound.halt_all_bg();
-            if (wave_over && !bonus->is_active()) {
-                //sound.halt_bonus();
-                bonus_launch_delay = 100000;
-                player_shot_delay = 100000;
-                // wait for explosions and shots to finish
-                if (no_explosions_active() && no_player_shots_active() && no_alien_shots_active()) {
-                    wave_cleanup();
-                    //sound.wait_for_all_to_finish();
-                    //sound.play_end_wave();
-                    return;
-                }
-            }
-
-            // run alien logic if neccessary
-            if (logic_this_loop) {
-                current_alien_speed = -current_alien_speed;
-                reference_alien->do_alien_logic();
-                logic_this_loop = false;
-            }
-
-            // draw everything
-            screen.begin_update();
+    }
+    void Game::draw_entities()
+    {
 #ifdef EVENT_COUNTER
-            event_counter.start_game_logic_section(7);
+        event_counter.start_game_logic_section(7);
 #endif
-            if (player->is_dirty())
-                player->draw();
-            if (bonus->is_dirty())
-                bonus->draw();
-
-            for (int i = 0; i < NUM_ALIENS; ++i) {
-                if (!aliens[i].is_dirty())
-                  continue;
-                Alien alien;
-                make_alien(aliens[i], reference_alien, &alien);
-                alien.draw();
+        if (player->is_dirty()) {
+            player->draw();
+#ifdef LATENCY_MONITOR
+            latency_monitor.end(LATENCY_MOVE);
+#endif
+        }
+        if (bonus->is_dirty())
+            bonus->draw();
+
+        // The aliens only need their sprite positions rewritten when the
+        // formation has moved by a whole pixel, and their data offsets when the
+        // formation animation has changed.  Aliens that were killed or
+        // activated are redrawn in full.
+        int16_t formation_x = reference_alien->get_x();
+        int16_t formation_y = reference_alien->get_y();
+        uint8_t formation_image = reference_alien->get_image_num();
+        uint8_t formation_fields[2];
+        for (uint8_t parity = 0; parity < 2; ++parity) {
+            uint8_t& fields = formation_fields[parity];
+            fields = 0;
+            if (redraw_formation & (1 << parity)) {
+                fields = Graphics::SPRITE_UPDATE_ALL;
+                continue;
             }
-            for (int i = 0; i < num_player_shots; ++i) {
-                if (player_shots[i].is_dirty()) {
-                    player_shots[i].draw();
-                }
+            if (formation_x != drawn_formation_x[parity] ||
+                formation_y != drawn_formation_y[parity]) {
+                fields |= Graphics::SPRITE_UPDATE_POSITION;
             }
-            for (int i = 0; i < num_alien_shots; ++i) {
-                if (alien_shots[i].is_dirty()) {
-                    alien_shots[i].draw();
-                }
+            if (formation_image != drawn_formation_image[parity])
+                fields |= Graphics::SPRITE_UPDATE_IMAGE;
+        }
+
+        // When over budget, alternate between redrawing the even and the odd
+        // aliens.  Each half keeps the formation state it was last drawn with,
+        // so it only rewrites the fields that have changed since then.
+        uint8_t alien_step = 1;
+        uint8_t first_alien = 0;
+        if (frame_budget.split_alien_redraws()) {
+            alien_step = 2;
+            first_alien = num_frames % 2;
+            set_formation_drawn(1 << first_alien);
+        } else {
+            set_formation_drawn(ALL_ALIEN_PARITIES);
+        }
+        for (int i = first_alien; i < NUM_ALIENS; i += alien_step) {
+            ReducedAlien& reduced_alien = aliens[i];
+            uint8_t fields = formation_fields[i % 2];
+            if (reduced_alien.is_dirty())
+                fields = Graphics::SPRITE_UPDATE_ALL;
+            else if (!reduced_alien.is_alive())
+                continue;
+            if (!fields)
+                continue;
+            Alien alien;
+            make_alien(reduced_alien, reference_alien, &alien);
+            alien.draw(fields);
+            reduced_alien.dirty = alien.is_dirty();
+        }
+        for (int i = 0; i < num_player_shots; ++i) {
+            if (player_shots[i].is_dirty()) {
+                player_shots[i].draw();
+#ifdef LATENCY_MONITOR
+                if (i == latency_shot_index)
+                    latency_monitor.end(LATENCY_FIRE);
+#endif
             }
-            for (int i = 0; i < num_explosions; ++i) {
-                if (explosions[i].is_dirty()) {
-                    explosions[i].draw();
-                }
+        }
+        for (int i = 0; i < num_alien_shots; ++i) {
+            if (alien_shots[i].is_dirty()) {
+                alien_shots[i].draw();
             }
-            for (int i = 0; i < NUM_SHIELD_GROUPS; ++i) {
-                uint8_t x = i * SHIELD_GROUP_X_SPACING / SCREEN_TILE_SIZE;
-                shield_group_tiles[i].draw(&screen, SHIELD_LAYER_INDEX, x,
-                                           0);
+        }
+        for (int i = 0; i < num_explosions; ++i) {
+            if (explosions[i].is_dirty()) {
+                explosions[i].draw();
             }
-            // Scroll starfields.  One scrolls slower than the other, for a neat
-            // parallax effect.
+        }
+        // When over budget, upload one run of shield tiles per frame.  The
+        // rest stay queued until later frames.
+        shield_tiles->draw(&screen, SHIELD_LAYER_INDEX,
+                           frame_budget.defer_shield_uploads() ?
+                               1 : SHIELD_TILE_WRITES_PER_FRAME);
+        // Scroll starfields.  One scrolls slower than the other, for a neat
+        // parallax effect.
+        if (!frame_budget.skip_starfield_scroll()) {
             screen.scroll_tile_layer(STARFIELD_LAYER_INDEX, 0,
                                      FIXED_TO_INT(starfield_y_offset));
             screen.scroll_tile_layer(STARFIELD2_LAYER_INDEX, 0,
                                      FIXED_TO_INT(starfield_y_offset) * 3 / 4);
-
-#ifdef EVENT_COUNTER
-            event_counter.end_game_logic_section(7);
-#endif
-            screen.update();
-
+        }
+        status.draw();
 #ifdef EVENT_COUNTER
-            event_counter.new_loop();
+        event_counter.end_game_logic_section(7);
 #endif
-        }
     }
     void Game::player_rebirth()
     {
@@ -1007,17 +1174,14 @@ namespace Game {
         screen.begin_update();
         player->draw();
         bonus->draw();
-        for (int i = 0; i < NUM_SHIELD_GROUPS; ++i) {
-            uint8_t x = i * SHIELD_GROUP_X_SPACING / SCREEN_TILE_SIZE;
-            shield_group_tiles[i].draw(&screen, SHIELD_LAYER_INDEX, x, 0);
-        }
+        shield_tiles->draw(&screen, SHIELD_LAYER_INDEX, NUM_SHIELD_TILES);
         for (int i = 0; i < NUM_ALIENS; ++i) {
             Alien alien;
             make_alien(aliens[i], reference_alien, &alien);
             alien.draw();
         }
         screen.update();
-        //sound.play_player_rebirth();
+        sound.play(Sound::PLAYER_REBIRTH);
     }
     void Game::wave_cleanup()
     {
@@ -1025,39 +1189,94 @@ namespace Game {
         // redraw all that should remain
         if (player->is_active())
             player->draw();
-        for (int i = 0; i < NUM_SHIELD_GROUPS; ++i) {
-            uint8_t x = i * SHIELD_GROUP_X_SPACING / SCREEN_TILE_SIZE;
-            shield_group_tiles[i].draw(&screen, SHIELD_LAYER_INDEX, x, 0);
+        // The last shot or explosion may have expired since the last
+        // draw_entities().  Draw whatever changed, so that dead entities give
+        // up their hardware sprites instead of staying on the screen into the
+        // next wave.
+        if (bonus->is_dirty())
+            bonus->draw();
+        for (int i = 0; i < num_player_shots; ++i) {
+            if (player_shots[i].is_dirty())
+                player_shots[i].draw();
+        }
+        for (int i = 0; i < num_alien_shots; ++i) {
+            if (alien_shots[i].is_dirty())
+                alien_shots[i].draw();
         }
+        for (int i = 0; i < num_explosions; ++i) {
+            if (explosions[i].is_dirty())
+                explosions[i].draw();
+        }
+        shield_tiles->draw(&screen, SHIELD_LAYER_INDEX, NUM_SHIELD_TILES);
         screen.update();
     }
+    void Game::show_message(const char* text, bool in_progmem)
+    {
+        uint8_t length = in_progmem ? strlen_P(text) : strlen(text);
+        uint8_t x = (length < MESSAGE_WIDTH) ? (MESSAGE_WIDTH - length) / 2
+                                             : 0;
+        font.clear_text(0, MESSAGE_ROW, MESSAGE_WIDTH);
+        if (in_progmem)
+            font.draw_text_P(x, MESSAGE_ROW, text);
+        else
+            font.draw_text(x, MESSAGE_ROW, text);
+    }
+    void Game::halt_background_sounds()
+    {
+        sound.halt(Sound::MARCH_1);
+    }
+    bool Game::mix_sound_when_idle(void* context)
+    {
+        Game* game = static_cast<Game*>(context);
+        if (game->unmixed_sound_time) {
+            game->sound.update(game->unmixed_sound_time);
+            game->unmixed_sound_time = 0;
+        }
+        return false;
+    }
+    void Game::update_march()
+    {
+        sound.set_march(Sound::MARCH_1,
+                        get_march_interval(current_alien_speed));
+    }
     void Game::pause()
     {
         uint32_t begin_pause;
-        //sound.halt_bonus();
-        //sound.halt_bg(alien_count);
+        sound.halt(Sound::ACTIVE_BONUS);
+        halt_background_sounds();
+        sound.update();
         begin_pause = System::get_ticks();
 
+        if (pause_state_writer)
+            save_state(pause_state_writer, pause_state_writer_context);
+
         // Wait for the pause key to be released before allowing resume.
         // This way, holding down the pause key will still pause the game.
         while (System::get_key_state().pause)
             System::delay(PAUSE_COOLDOWN_TIME);
 
-        while (!System::get_key_state().pause);
+        while (!System::get_key_state().pause)
+            System::delay(PAUSE_POLL_TIME);
 
         System::delay(PAUSE_COOLDOWN_TIME);
         last_loop_time +=  System::get_ticks() - begin_pause;
         last_bonus_launch = last_alien_shot = System::get_ticks();
-        //sound.play_bonus();
+        if (bonus->is_active())
+            sound.play_loop(Sound::ACTIVE_BONUS);
+        update_march();
     }
-    void Game::fire_shot()
+    void Game::fire_shot(uint32_t time)
     {
         // check that player has waited long enough to fire
-        if (System::get_ticks() - last_shot < player_shot_delay) {
+        if (time - last_shot < player_shot_delay) {
             return;
         }
         // record time and fire
-        last_shot = System::get_ticks();
+        last_shot = time;
+#ifdef LATENCY_MONITOR
+        if (latency_monitor.start(LATENCY_FIRE, time))
+            latency_shot_index = player_shot_counter;
+#endif
         player_shots[player_shot_counter].init_x(player->get_x()+player_init_x_shot_pos);
         player_shots[player_shot_counter].init_y(player->get_y()-player_init_y_shot_pos);
         player_shots[player_shot_counter].set_hit(false);
@@ -1065,7 +1284,7 @@ namespace Game {
         if (++player_shot_counter == num_player_shots) {
             player_shot_counter = 0;
         }
-        //sound.play_shot();
+        sound.play(Sound::SHOT);
     }
     void Game::launch_bonus_ship()
     {
@@ -1073,7 +1292,6 @@ namespace Game {
             return;
         }
         last_bonus_launch = System::get_ticks();
-        static int rand_list_count = 0;
         if (bonus_select[rand_list_count] == 1) {
             bonus = sbonus;
         } else {
@@ -1090,7 +1308,7 @@ namespace Game {
             current_bonus_speed = -bonus_speed;
             bonus->activate();
         }
-        //sound.play_bonus();
+        sound.play_loop(Sound::ACTIVE_BONUS);
         bonus_launch_delay = base_launch_delay + (1000 * launch_delay[rand_list_count]);
         if (++rand_list_count == random_list_len) {
             rand_list_count = 0;
@@ -1104,7 +1322,6 @@ namespace Game {
         }
         // record time and fire
         last_alien_shot = System::get_ticks();
-        static int alien_to_fire = 0;
         ++alien_to_fire;
         for (int i = 0; i < NUM_ALIENS; ++i) {
             ReducedAlien& alien = aliens[i];
@@ -1124,10 +1341,11 @@ namespace Game {
     }
     void Game::msg_alien_player_collide()
     {
-        //sound.play_explode();
+        sound.play(Sound::EXPLOSION);
         player_dead = true;
         if (!(--alien_count)) {
             wave_over = true;
+            halt_background_sounds();
         }
     }
     void Game::msg_alien_landed()
@@ -1139,38 +1357,39 @@ namespace Game {
     {
         player_shot_delay = 100000;
         player_dead = true;
-        //sound.play_explode();
+        sound.play(Sound::EXPLOSION);
     }
     inline void Game::free_guy_check()
     {
         if (score >= next_free_guy) {
-            //sound.play_free_guy();
+            sound.play(Sound::FREE_GUY);
             ++player_life;
-            //status.blit_lives(player_life);
-            //status.blit_player_ships(player_life, images.get_image_index("ship.png"));
-            next_free_guy += free_guy_val;
+            status.set_lives(player_life);
+            next_free_guy.add(BCD(BCD_CONSTANT(free_guy_val)));
         }
     }
-    void Game::msg_bonus_ship_destroyed(int bonus)
+    void Game::msg_bonus_ship_destroyed(uint16_t bonus)
     {
-        score += bonus;
-        if (bonus == 1000) {
-            //sound.play_rbonus();
+        sound.halt(Sound::ACTIVE_BONUS);
+        score.add(BCD(bonus));
+        if (bonus == BCD_CONSTANT(1000)) {
+            sound.play(Sound::BIG_BONUS);
         } else {
-            //sound.play_sbonus();
+            sound.play(Sound::SMALL_BONUS);
         }
-        //status.blit_score(score);
+        status.set_score(score);
         free_guy_check();
     }
-    void Game::msg_alien_killed(int index, int points)
+    void Game::msg_alien_killed(int index, uint16_t points)
     {
-        //sound.play_alien_dead();
-        score += points;
+        sound.play(Sound::ALIEN_DEATH);
+        score.add(BCD(points));
+        status.set_score(score);
         free_guy_check();
-        //status.blit_score(score);
         // when all aliens are destroyed, wave over
         if (--alien_count == 0) {
             wave_over = true;
+            halt_background_sounds();
             return;
         }
         // Set the alien above the one just killed to active.  If the above one
@@ -1184,24 +1403,13 @@ namespace Game {
             next_alien_index -= ALIEN_ARRAY_WIDTH;
         }
 
-        // speed up all the existing aliens, whenever one is destroyed
+        // speed up all the existing aliens, whenever one is destroyed.  The
+        // speeds come from a table, so keep the current direction.  |wave| has
+        // already been incremented for the current wave.
+        fixed new_speed = get_alien_speed(wave - 1, alien_count);
         current_alien_speed =
-           increase_speed(current_alien_speed, ALIEN_SPEED_BOOST);
-        switch (alien_count) {
-        case 4:
-        case 2:
-        case 1:
-            current_alien_speed =
-                increase_speed(current_alien_speed,
-                               ALIEN_SPEED_BOOST_EXTRA);
-            //sound.halt_bg(alien_count);
-            break;
-        case 3:
-            //sound.halt_bg(alien_count);
-            break;
-        default:
-            break;
-        }
+            (current_alien_speed < 0) ? -new_speed : new_speed;
+        update_march();
     }
     bool Game::collides_with_shield_group(GameEntity* object, uint8_t* group) {
         for (int i = 0; i < NUM_SHIELD_GROUPS; ++i) {
@@ -1243,20 +1451,341 @@ namespace Game {
             explosion_counter = 0;
         }
     }
+    void Game::save_state(StateWriter writer, void* context)
+    {
+        // Do a dry run first to get the size of the state.
+        StateStream counter(NULL, NULL, context);
+        transfer_state(&counter);
+
+        SaveStateHeader header;
+        header.magic = SAVE_STATE_MAGIC;
+        header.version = SAVE_STATE_VERSION;
+        header.size = counter.get_size();
+        writer(&header, sizeof(header), context);
+
+        StateStream stream(writer, NULL, context);
+        transfer_state(&stream);
+    }
+    bool Game::load_state(StateReader reader, void* context)
+    {
+        SaveStateHeader header;
+        if (!reader(&header, sizeof(header), context))
+            return false;
+
+        StateStream counter(NULL, NULL, context);
+        transfer_state(&counter);
+        if (header.magic != SAVE_STATE_MAGIC ||
+            header.version != SAVE_STATE_VERSION ||
+            header.size != counter.get_size()) {
+            printf_P("Saved state does not match this build.\n");
+            return false;
+        }
+
+        StateStream stream(NULL, reader, context);
+        transfer_state(&stream);
+        if (!stream.is_ok())
+            return false;
+
+        // The shield tiles are not saved, since they can be regenerated from
+        // the shield pieces.
+        shield_tiles->init(shields);
+
+        redraw_all();
+        return true;
+    }
+    void Game::transfer_state(StateStream* stream)
+    {
+#define TRANSFER(x)      stream->transfer(&(x), sizeof(x))
+        // Game variables.
+        TRANSFER(alien_count);
+        TRANSFER(wave);
+        TRANSFER(player_life);
+        TRANSFER(alien_odd_range);
+        TRANSFER(num_alien_shots);
+        TRANSFER(current_player_speed);
+        TRANSFER(current_bonus_speed);
+        TRANSFER(current_alien_speed);
+        TRANSFER(player_shot_counter);
+        TRANSFER(alien_shot_counter);
+        TRANSFER(explosion_counter);
+        TRANSFER(starfield_y_offset);
+        TRANSFER(delta);
+        TRANSFER(score);
+        TRANSFER(player_shot_delay);
+        TRANSFER(alien_shot_delay);
+        TRANSFER(bonus_launch_delay);
+        TRANSFER(next_free_guy);
+        TRANSFER(num_frames);
+        TRANSFER(rand_list_count);
+        TRANSFER(alien_to_fire);
+        TRANSFER(logic_this_loop);
+        TRANSFER(player_dead);
+        TRANSFER(wave_over);
+        TRANSFER(aliens_landed);
+
+        uint32_t now = System::get_ticks();
+        transfer_time(stream, &last_shot, now);
+        transfer_time(stream, &last_alien_shot, now);
+        transfer_time(stream, &last_bonus_launch, now);
+        transfer_time(stream, &last_loop_time, now);
+        transfer_time(stream, &dead_pause, now);
+
+        bool small_bonus = (bonus == sbonus);
+        TRANSFER(small_bonus);
+        if (stream->is_loading())
+            bonus = small_bonus ? sbonus : rbonus;
+
+        // Explosion durations are stored in the type properties.
+        GameEntityTypeProperties explosion_prop =
+            *GameEntity::get_type_property(GAME_ENTITY_EXPLOSION);
+        TRANSFER(explosion_prop.frame_duration);
+        if (stream->is_loading())
+            GameEntity::set_type_property(GAME_ENTITY_EXPLOSION, explosion_prop);
+
+        // Entities.
+        TRANSFER(*player);
+        TRANSFER(*rbonus);
+        TRANSFER(*sbonus);
+        TRANSFER(*reference_alien);
+        stream->transfer(aliens, NUM_ALIENS * sizeof(aliens[0]));
+        stream->transfer(num_aliens_per_col,
+                         ALIEN_ARRAY_WIDTH * sizeof(num_aliens_per_col[0]));
+        stream->transfer(shields, NUM_SHIELDS * sizeof(shields[0]));
+        stream->transfer(player_shots,
+                         num_player_shots * sizeof(player_shots[0]));
+        stream->transfer(alien_shots,
+                         MAX_NUM_ALIEN_SHOTS * sizeof(alien_shots[0]));
+        stream->transfer(explosions, num_explosions * sizeof(explosions[0]));
+
+        // Random lists.
+        stream->transfer(direction, random_list_len * sizeof(direction[0]));
+        stream->transfer(bonus_select,
+                         random_list_len * sizeof(bonus_select[0]));
+        stream->transfer(launch_delay,
+                         random_list_len * sizeof(launch_delay[0]));
+#undef TRANSFER
+    }
+    void Game::transfer_time(StateStream* stream, uint32_t* time, uint32_t now)
+    {
+        uint32_t time_ago = now - *time;
+        stream->transfer(&time_ago, sizeof(time_ago));
+        if (stream->is_loading())
+            *time = now - time_ago;
+    }
+    void Game::set_formation_drawn(uint8_t parities)
+    {
+        for (uint8_t parity = 0; parity < 2; ++parity) {
+            if (!(parities & (1 << parity)))
+                continue;
+            drawn_formation_x[parity] = reference_alien->get_x();
+            drawn_formation_y[parity] = reference_alien->get_y();
+            drawn_formation_image[parity] = reference_alien->get_image_num();
+        }
+        redraw_formation &= ~parities;
+    }
+    void Game::redraw_all()
+    {
+        screen.begin_update();
+        player->draw();
+        rbonus->draw();
+        sbonus->draw();
+        for (int i = 0; i < NUM_ALIENS; ++i) {
+            Alien alien;
+            make_alien(aliens[i], reference_alien, &alien);
+            alien.draw();
+        }
+        set_formation_drawn(ALL_ALIEN_PARITIES);
+        for (int i = 0; i < num_player_shots; ++i)
+            player_shots[i].draw();
+        for (int i = 0; i < num_alien_shots; ++i)
+            alien_shots[i].draw();
+        for (int i = 0; i < num_explosions; ++i)
+            explosions[i].draw();
+        shield_tiles->draw(&screen, SHIELD_LAYER_INDEX, NUM_SHIELD_TILES);
+        status.set_score(score);
+        status.set_wave(wave);
+        status.set_lives(player_life);
+        status.draw();
+        screen.update();
+    }
+#ifdef BENCHMARK
+    void Game::run_benchmarks()
+    {
+        Benchmark::print_header();
+
+        // Micro-benchmarks of the per-object primitives.
+        Benchmark bench;
+        Alien alien;
+        bench.begin("micro", "make_alien", BENCHMARK_ITERATIONS);
+        for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i)
+            make_alien(aliens[i % NUM_ALIENS], reference_alien, &alien);
+        bench.end();
+
+        bench.begin("micro", "collides_with", BENCHMARK_ITERATIONS);
+        for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i)
+            player->collides_with(&alien);
+        bench.end();
+
+        bench.begin("micro", "update_sprite", BENCHMARK_ITERATIONS);
+        for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i)
+            screen.update_sprite(player);
+        bench.end();
+
+        // Every iteration toggles one shield piece, so there is always a tile
+        // to upload.
+        bench.begin("micro", "shield_tiles_draw", BENCHMARK_ITERATIONS);
+        for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+            ShieldPiece& shield = shields[i % NUM_SHIELDS];
+            shield.intact = !shield.intact;
+            shield_tiles->update_shield_piece(shield);
+            shield_tiles->draw(&screen, SHIELD_LAYER_INDEX,
+                               SHIELD_TILE_WRITES_PER_FRAME);
+        }
+        bench.end();
+
+        // Whole game loop steps, starting from a fresh wave.  Each scenario
+        // adds to the state left behind by the previous one.
+        benchmark_game_loop("full_formation");
+
+        fill_shots();
+        benchmark_game_loop("max_alien_shots");
+
+        break_shields(2);
+        benchmark_game_loop("shields_half_destroyed");
+
+        thin_alien_formation(4);
+        benchmark_game_loop("sparse_formation");
+    }
+    void Game::benchmark_game_loop(const char* scenario)
+    {
+        // Every iteration starts from the scenario state and does one frame's
+        // worth of work: a movement step, then the collisions or drawing after
+        // it.  There is only room for one saved state, so the time to load the
+        // state and move is subtracted from the later paths.
+        delta = FRAME_PERIOD_TICKS;
+        redraw_all();
+
+        BenchmarkState start_state;
+        if (!save_benchmark_state(&start_state))
+            return;
+
+        Benchmark bench;
+        uint32_t start_time = System::get_ticks();
+        for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i)
+            load_benchmark_state(&start_state);
+        uint32_t load_time = System::get_ticks() - start_time;
+
+        start_time = System::get_ticks();
+        bench.begin(scenario, "movement", BENCHMARK_ITERATIONS);
+        for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+            load_benchmark_state(&start_state);
+            move_entities();
+        }
+        bench.end(load_time);
+        uint32_t move_time = System::get_ticks() - start_time;
+
+        bench.begin(scenario, "collisions", BENCHMARK_ITERATIONS);
+        for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+            load_benchmark_state(&start_state);
+            move_entities();
+            handle_collisions();
+        }
+        bench.end(move_time);
+
+        // The screen still shows the scenario state, so each draw is of the
+        // changes from that.
+        bench.begin(scenario, "draw", BENCHMARK_ITERATIONS);
+        for (uint16_t i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+            load_benchmark_state(&start_state);
+            set_formation_drawn(ALL_ALIEN_PARITIES);
+            move_entities();
+            draw_entities();
+        }
+        bench.end(move_time);
+
+        load_benchmark_state(&start_state);
+        redraw_all();
+    }
+    bool Game::save_benchmark_state(BenchmarkState* state)
+    {
+        StateStream stream(BenchmarkState::write_state, NULL, state);
+        transfer_state(&stream);
+        if (state->is_full()) {
+            printf_P("Benchmark state needs %u bytes.\n", state->size);
+            return false;
+        }
+        return true;
+    }
+    void Game::load_benchmark_state(BenchmarkState* state)
+    {
+        state->rewind();
+        StateStream stream(NULL, BenchmarkState::read_state, state);
+        transfer_state(&stream);
+        // The shield tiles are not part of the state.
+        shield_tiles->init(shields);
+    }
+    void Game::thin_alien_formation(uint8_t keep_interval)
+    {
+        // Keep every |keep_interval|-th alien and kill the rest.
+        for (int i = 0; i < NUM_ALIENS; ++i) {
+            ReducedAlien& alien = aliens[i];
+            if (i % keep_interval == 0 || !alien.is_alive())
+                continue;
+            alien.alive = false;
+            alien.dirty = true;
+            --num_aliens_per_col[alien.col];
+            --alien_count;
+        }
+    }
+    void Game::fill_shots()
+    {
+        // Spread the shots out between the bottom of the alien formation and
+        // the top of the shields, so that none of them collide.
+        num_alien_shots = MAX_NUM_ALIEN_SHOTS;
+        for (int i = 0; i < num_alien_shots; ++i) {
+            alien_shots[i].Shot_init(num_player_shots + i,
+                                     (i * screen_w) / num_alien_shots,
+                                     120 + (i % 2) * SHOT_HEIGHT * 2, true);
+        }
+        for (int i = 0; i < num_player_shots; ++i) {
+            player_shots[i].Shot_init(i,
+                                      (i * screen_w) / num_player_shots + 4,
+                                      120 + SHOT_HEIGHT, true);
+        }
+    }
+    void Game::break_shields(uint8_t interval)
+    {
+        for (int i = 0; i < NUM_SHIELDS; i += interval) {
+            shields[i].intact = false;
+            shield_tiles->update_shield_piece(shields[i]);
+        }
+    }
+#endif  // defined(BENCHMARK)
     Game::Game(Screen* screen_ptr) :
                    // ui(&sound, this, 0),
                    screen(*screen_ptr),
+                   font(screen_ptr, TEXT_LAYER_INDEX),
+                   status(&font),
                    player_life(0),
                    player(NULL),
                    bonus(NULL),
                    sbonus(NULL),
-                   rbonus(NULL)
+                   rbonus(NULL),
+                   unmixed_sound_time(0),
+                   pause_state_writer(NULL),
+                   initial_state_reader(NULL)
     {
         GameEntity::set_game(this);
         GameEntity::set_screen(&screen);
+        screen.set_idle_task(mix_sound_when_idle, this);
+#ifdef LATENCY_MONITOR
+        latency_shot_index = 0;
+#endif
     }
     Game::~Game()
     {
+        screen.set_idle_task(NULL, NULL);
         GameEntity::set_game(NULL);
+        GameEntity::set_screen(NULL);
     }
 }
@@ -38,9 +38,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "bcd.h"
+#include "benchmark.h"
 #include "fixed_point.h"
+#include "frame_budget.h"
+#include "latency_monitor.h"
 #include "screen.h"
 #include "sound.h"
+#include "state_stream.h"
 #include "status.h"
 #include "system.h"
 #include "ui.h"
@@ -93,14 +98,15 @@ namespace Game {
 
     };
 
-    struct ShieldGroupTiles;
+    class ShieldTiles;
 
     class Game {
         typedef GameEntities::GameEntity* GameEntityPtr;
-        // Sound::Sound sound;
+        Sound::Sound sound;
         // Ui::Ui ui;
-        // Ui::Status status;
         Graphics::Screen& screen;
+        Ui::TTFont font;
+        Ui::Status status;
         GameEntityPtr player, rbonus, sbonus, bonus;
 
         // Instantiate one actual alien object as a reference.
@@ -119,7 +125,7 @@ namespace Game {
         // no collision.
         GameEntities::GameEntity* shield_groups;
         // For drawing shield groups.
-        ShieldGroupTiles* shield_group_tiles;
+        ShieldTiles* shield_tiles;
         int* direction;
         int* bonus_select;
         int* launch_delay;
@@ -128,10 +134,51 @@ namespace Game {
         fixed current_alien_speed;
         int player_shot_counter, alien_shot_counter, explosion_counter;
         fixed starfield_y_offset;
-        uint32_t last_shot, last_alien_shot, last_bonus_launch, last_loop_time, delta, score, dead_pause;
-        uint32_t player_shot_delay, alien_shot_delay, bonus_launch_delay, next_free_guy;
+        uint32_t last_shot, last_alien_shot, last_bonus_launch, last_loop_time, delta, dead_pause;
+        uint32_t player_shot_delay, alien_shot_delay, bonus_launch_delay;
+        // Kept in BCD, so the status display never has to divide.
+        BCD score, next_free_guy;
+        uint32_t num_frames;    // Number of game loops run in this game.
+        // Position in the bonus ship random lists, and the fire chance value
+        // of the aliens that fire next.
+        uint8_t rand_list_count, alien_to_fire;
         bool logic_this_loop, player_dead, wave_over, aliens_landed;
+        // Tracks the frame time and how much drawing work to skip.
+        FrameBudget frame_budget;
+        // Game time that the sound has not been mixed for yet.  The mixing is
+        // done while waiting for the display when possible, so it stays out
+        // of the vertical blank.
+        uint32_t unmixed_sound_time;
+        // Formation position and animation image as of the last time the
+        // even (index 0) and the odd (index 1) aliens were drawn.  They only
+        // differ while the frame budget splits the alien redraws.  Bit N of
+        // |redraw_formation| is set if the values at index N are not valid and
+        // those aliens must be redrawn in full.
+        int16_t drawn_formation_x[2], drawn_formation_y[2];
+        uint8_t drawn_formation_image[2];
+        uint8_t redraw_formation;
+#ifdef LATENCY_MONITOR
+        // The shot whose first draw ends the fire latency measurement.
+        uint8_t latency_shot_index;
+#endif
+        // For saving the state when paused, and for starting from a saved
+        // state.
+        StateWriter pause_state_writer;
+        void* pause_state_writer_context;
+        StateReader initial_state_reader;
+        void* initial_state_reader_context;
         void free_guy_check();
+        // Records the current formation state as drawn, for the aliens whose
+        // index parities are set in |parities|.
+        void set_formation_drawn(uint8_t parities);
+        void halt_background_sounds();
+        // Screen idle task.  Mixes the sound for |unmixed_sound_time|.
+        static bool mix_sound_when_idle(void* context);
+        // Draws |text| in the middle of the screen, over any previous
+        // message.
+        void show_message(const char* text, bool in_progmem);
+        // Sets the tempo of the background march from the alien speed.
+        void update_march();
         void init_aliens(int rand_max);
         void pause();
         bool collides_with_shield_group(GameEntities::GameEntity* object,
@@ -141,12 +188,40 @@ namespace Game {
         bool no_explosions_active();
         void launch_bonus_ship();
         void alien_fire();
-        void fire_shot();
+        // Fires a shot for a fire key press at |time|.
+        void fire_shot(uint32_t time);
+        // Sets up everything that stays the same for the whole game: entity
+        // type properties, sprites, and tile layers.
+        void setup_game();
         void init_wave();
+        // Resets the entities and difficulty parameters for a new wave.
         void factory();
         void game_loop();
+        // Steps of a single game loop iteration.
+        void move_entities();
+        void handle_collisions();
+        void draw_entities();
         void wave_cleanup();
         void player_rebirth();
+        // Saves or loads every part of the simulation state.
+        void transfer_state(StateStream* stream);
+        // Transfers a timestamp relative to |now|, so it stays valid after
+        // loading into a game with a different clock.
+        void transfer_time(StateStream* stream, uint32_t* time, uint32_t now);
+        // Draws all entities and shields, whether dirty or not.
+        void redraw_all();
+#ifdef BENCHMARK
+        // Benchmark scenarios.  Each one modifies the current game state.
+        void run_benchmarks();
+        void benchmark_game_loop(const char* scenario);
+        void thin_alien_formation(uint8_t keep_interval);
+        void fill_shots();
+        void break_shields(uint8_t interval);
+        // Copies the simulation state to or from memory, so that every
+        // benchmark iteration starts from the same state.
+        bool save_benchmark_state(BenchmarkState* state);
+        void load_benchmark_state(BenchmarkState* state);
+#endif
     public:
         Game(Graphics::Screen* screen);
         ~Game();
@@ -154,9 +229,41 @@ namespace Game {
         void game_control();
         void msg_player_dead();
         void msg_alien_landed();
-        void msg_alien_killed(int index, int points);
+        void msg_alien_killed(int index, uint16_t points);
         void msg_alien_player_collide();
-        void msg_bonus_ship_destroyed(int bonus);
+        void msg_bonus_ship_destroyed(uint16_t bonus);
+
+        // Sets the sound effect clips, indexed by Sound::Effect.
+        void set_sound_clips(const Sound::SoundClip* clips) {
+            sound.set_clips(clips);
+        }
+
+        // Writes the complete simulation state as a versioned binary blob.
+        // Can only be called while the game is running.
+        void save_state(StateWriter writer, void* context);
+        // Restores a state written by save_state() and redraws the screen.
+        // Returns false without changing anything if the header does not
+        // match this build.  If the reader runs out of data partway through,
+        // returns false with the game state partially overwritten.
+        bool load_state(StateReader reader, void* context);
+
+        // Calls save_state() with |writer| every time the game is paused.
+        void set_pause_state_writer(StateWriter writer, void* context) {
+            pause_state_writer = writer;
+            pause_state_writer_context = context;
+        }
+        // Makes game_control() load a saved state after setting up the first
+        // wave, so the game continues from there.
+        void set_initial_state(StateReader reader, void* context) {
+            initial_state_reader = reader;
+            initial_state_reader_context = context;
+        }
+
+        // Results of the game, for use after game_control() returns.
+        uint32_t get_score() const { return score.to_binary(); }
+        int get_wave() const { return wave; }
+        uint32_t get_num_frames() const { return num_frames; }
+
         void run_logic(const GameEntities::GameEntity* entity) {
             // The reference alien movement is used to update location and
             // animation. Do run change-of-direction logic on it.
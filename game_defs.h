@@ -36,6 +36,22 @@
 #include "screen.h"
 
 // The formation of aliens.
+//
+// The aliens are drawn as sprites rather than on a tile layer, even though the
+// formation moves as one.  A tile layer would make an animation-only change a
+// single TILE_DATA_OFFSET write, with a copy of the tiles for each animation
+// image.  But the formation spacing (ALIEN_STEP_X/Y) is not a multiple of
+// SCREEN_TILE_SIZE, so aliens straddle tile boundaries, and the alien images
+// are stored in sprite layout, not as 16x16 tiles.  Every alien/tile overlap
+// would need its own tile in VRAM, rewritten on every kill, which costs far
+// more than the sprite writes it saves.
+//
+// Redundant formation sprite writes are skipped instead.  Game::draw_entities()
+// works out which sprite fields the formation changed since it was last drawn,
+// and passes that mask to GameEntity::draw(fields), which has
+// Screen::update_sprite() write only those fields.  A formation that has not
+// moved costs no writes, and an animation-only change is one
+// SPRITE_DATA_OFFSET write per alien.
 #define ALIEN_ARRAY_WIDTH    12
 #define ALIEN_ARRAY_HEIGHT    5
 #define NUM_ALIENS      (ALIEN_ARRAY_WIDTH * ALIEN_ARRAY_HEIGHT)
@@ -46,8 +62,10 @@
 #define ALIEN_STEP_Y         14
 #define ALIEN_Y_MOVEMENT      4
 
-#define ALIEN_SPEED_BOOST            (FIXED_POINT_FACTOR_32 * 1.027)
-#define ALIEN_SPEED_BOOST_EXTRA      (FIXED_POINT_FACTOR_32 * 1.15)
+// The background march plays one beat each time the aliens move this many
+// pixels, but never more often than every MARCH_MIN_INTERVAL samples.
+#define MARCH_STEP_DISTANCE  ALIEN_STEP_X
+#define MARCH_MIN_INTERVAL  800
 
 // For generating shield pieces.
 #define NUM_SHIELD_GROUPS            3
@@ -105,9 +123,8 @@
 #define bonus_speed                                80
 #define shot_speed                               -120
 #define alien_shot_speed                           80
-#define ALIEN_BASE_SPEED                           32
-#define ALIEN_WAVE_SPEED_INCREASE                   2
-#define ALIEN_HIGH_WAVE_SPEED_INCREASE              1
+// Alien speeds and other per-wave difficulty settings are generated into
+// difficulty_table.h by tools/gen_difficulty_table.py.
 
 // Initial bonus ship delay in ms.
 #define base_launch_delay                            6000
@@ -130,6 +147,7 @@ enum {
   BASE_PALETTE_INDEX,
   STARFIELD_PALETTE1_INDEX,
   STARFIELD_PALETTE2_INDEX,
+  FONT_PALETTE_INDEX,
 };
 
 #endif  // GAME_DEFS_H
@@ -54,10 +54,12 @@ namespace GameEntities {
         this->image_num = 0;
     }
 
-    void GameEntity::draw()
+    void GameEntity::draw(uint8_t fields)
     {
-        screen->update_sprite(this);
-        dirty = false;
+        // Stay dirty if there was no hardware sprite, so that the next draw
+        // tries again.
+        if (screen->update_sprite(this, fields))
+            dirty = false;
     }
     bool GameEntity::collides_with(GameEntity* other)
     {
@@ -135,7 +137,11 @@ namespace GameEntities {
     }
     void GameEntity::movement(int16_t delta, int speed)
     {
-        bool do_movement = true;
+        // Positions are in fixed point, so most movements are less than a
+        // pixel.  Only redraw when the drawn position or image changes.
+        int old_x = x_int();
+        int old_y = y_int();
+        uint8_t old_image_num = image_num;
         switch(type) {
         case GAME_ENTITY_PLAYER:
             Player_movement(delta, speed);
@@ -157,11 +163,12 @@ namespace GameEntities {
         case GAME_ENTITY_EXPLOSION:
         case GAME_ENTITY_SHIELD_GROUP:
         default:
-            do_movement = false;
             break;
         }
-        // No movement, no redraw.
-        dirty = do_movement;
+        // Don't clear |dirty| here, since it may have been set by something
+        // else that still needs to be drawn.
+        if (x_int() != old_x || y_int() != old_y || image_num != old_image_num)
+            dirty = true;
 #ifdef EVENT_COUNTER
         event_counter.do_movement_call();
 #endif
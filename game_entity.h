@@ -55,7 +55,7 @@ namespace GameEntities {
     // use this struct to store the common property values and save memory.
     struct GameEntityTypeProperties {
         uint16_t frame_duration;  // How much time before going to next frame.
-        uint16_t points; // point value of individual objects
+        uint16_t points; // point value of individual objects, in BCD
 
         // width and height of the object image.
         // These should be <= 255.
@@ -115,7 +115,7 @@ namespace GameEntities {
         GameEntityTypeProperties* properties() const {
             return &type_properties[type];
         }
-        void draw();
+        void draw(uint8_t fields = Graphics::SPRITE_UPDATE_ALL);
         bool is_active() const {
             return active && is_alive();
         }
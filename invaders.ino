@@ -42,13 +42,28 @@
 #include "game_defs.h"
 #include "printf.h"
 #include "screen.h"
+#include "sound.h"
 #include "system.h"
+#include "ttf.h"
+
+#ifdef SOUND_DATA
+// sound_data.h is generated, not checked in.
+#ifdef __has_include
+#if !__has_include("sound_data.h")
+#error "SOUND_DATA needs sound_data.h: run tools/gen_sound_pack.py --header sound_data.h"
+#endif
+#endif
+#include "sound_data.h"
+#endif
 
 extern uint8_t __bss_end;
 extern uint8_t __stack;
 
 // VRAM offsets of image data.
 uint16_t g_vram_offsets[NUM_GAME_ENTITY_TYPES];
+// VRAM offset of the font atlas generated by tools/gen_font_atlas.py.  Stays
+// FONT_NOT_LOADED if data/font.raw is missing, which leaves text turned off.
+uint16_t g_font_vram_offset = FONT_NOT_LOADED;
 
 namespace {
 
@@ -74,6 +89,7 @@ const char kFilenames[] PROGMEM =
   "shot.raw\0"
   "shield.raw\0"
   "explode.raw\0"
+  "font.raw\0"
   "palette.pal\0"
 ;
 
@@ -89,6 +105,7 @@ const File kFiles[] PROGMEM = {
   { NULL, &g_vram_offsets[GAME_ENTITY_SHOT], 0, 0, VRAM_BANK_SIZE },
   { NULL, &g_vram_offsets[GAME_ENTITY_SHIELD_PIECE], 0, 0, VRAM_BANK_SIZE },
   { NULL, &g_vram_offsets[GAME_ENTITY_EXPLOSION], 0, 0, VRAM_BANK_SIZE },
+  { NULL, &g_font_vram_offset, 0, 0, VRAM_BANK_SIZE },
 
   // Palette data.
   { NULL, NULL, PALETTE(BASE_PALETTE_INDEX), 0, PALETTE_SIZE },
@@ -173,9 +190,56 @@ void loadResources() {
   DC.Core.writeWord(REG_SYS_CTRL, (0 << REG_SYS_CTRL_VRAM_ACCESS));
 }
 
+#ifdef SIMULATION_RUNNER
+// Plays NUM_SIMULATED_GAMES seeded games with the scripted player and prints
+// the results of each game, followed by a summary.
+void runSimulations(Graphics::Screen* screen) {
+  uint32_t total_score = 0, max_score = 0;
+  uint32_t total_waves = 0, max_wave = 0;
+  uint32_t total_frames = 0, total_real_ticks = 0;
+
+  printf_P("SIM,seed,score,wave,frames,ticks\n");
+  for (uint16_t seed = 1; seed <= NUM_SIMULATED_GAMES; ++seed) {
+    srand(seed);
+    System::init_simulation(seed);
+
+    uint32_t start_time = System::get_real_ticks();
+    Game::Game game(screen);
+    game.game_control();
+    uint32_t real_ticks = System::get_real_ticks() - start_time;
+
+    uint32_t score = game.get_score();
+    uint32_t wave = game.get_wave();
+    printf_P("SIM,%u,%lu,%lu,%lu,%lu\n",
+             seed, score, wave, game.get_num_frames(), real_ticks);
+
+    total_score += score;
+    total_waves += wave;
+    total_frames += game.get_num_frames();
+    total_real_ticks += real_ticks;
+    if (score > max_score)
+      max_score = score;
+    if (wave > max_wave)
+      max_wave = wave;
+  }
+
+  printf_P("Simulated %u games\n", NUM_SIMULATED_GAMES);
+  printf_P("- Average score: %lu, max: %lu\n",
+           total_score / NUM_SIMULATED_GAMES, max_score);
+  printf_P("- Average wave: %lu, max: %lu\n",
+           total_waves / NUM_SIMULATED_GAMES, max_wave);
+  if (total_frames > 0) {
+    printf_P("- Average frame cost in microseconds: %lu\n",
+             (uint32_t)((uint64_t)total_real_ticks * 1000 / total_frames));
+  }
+}
+#endif  // defined(SIMULATION_RUNNER)
+
 }  // namespace
 
 void setup() {
+    System::paint_stack();
+
     Serial.begin(115200);
     DC.begin();
 
@@ -191,8 +255,15 @@ void setup() {
     // Initialize video screen and image library.
     screen.init();
 
+#ifdef SIMULATION_RUNNER
+    runSimulations(&screen);
+#else
     Game::Game game(&screen);
+#ifdef SOUND_DATA
+    game.set_sound_clips(kSoundClips);
+#endif
     game.game_control();
+#endif
 
     printf_P("End of program.\n");
 }
@@ -0,0 +1,88 @@
+/*
+ latency_monitor.cpp
+ Classic Invaders
+
+ Copyright (c) 2013, Todd Steinackle, Simon Que
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the documentation and/or other
+ materials provided with the distribution.
+
+ * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)  nor the names of
+ its contributors may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "latency_monitor.h"
+
+#include "printf.h"
+#include "system.h"
+
+void LatencyMonitor::end(LatencyType type)
+{
+    if (!(measuring & (1 << type)))
+        return;
+    measuring &= ~(1 << type);
+
+    uint32_t latency = System::get_ticks() - start_times[type];
+    Histogram& histogram = histograms[type];
+    uint8_t bucket = LATENCY_NUM_BUCKETS - 1;
+    if (latency < LATENCY_NUM_BUCKETS * LATENCY_BUCKET_TICKS)
+        bucket = latency / LATENCY_BUCKET_TICKS;
+    ++histogram.buckets[bucket];
+    ++histogram.count;
+    histogram.total += latency;
+    if (latency > histogram.max)
+        histogram.max = (latency > UINT16_MAX) ? UINT16_MAX : latency;
+}
+
+void LatencyMonitor::new_wave(int wave)
+{
+    if (wave > 1) {
+        printf_P("Input latency in wave %d:\n", wave - 1);
+        report();
+    }
+    reset();
+}
+
+void LatencyMonitor::report()
+{
+    for (uint8_t type = 0; type < NUM_LATENCY_TYPES; ++type) {
+        const Histogram& histogram = histograms[type];
+        printf_P("- %s: ", (type == LATENCY_MOVE) ? "Move" : "Fire");
+        if (histogram.count == 0) {
+            printf_P("no presses\n");
+            continue;
+        }
+        printf_P("%u presses, average %lu ticks, max %u ticks\n",
+                 histogram.count, histogram.total / histogram.count,
+                 histogram.max);
+        printf_P("  ");
+        for (uint8_t i = 0; i < LATENCY_NUM_BUCKETS; ++i) {
+            if (i == LATENCY_NUM_BUCKETS - 1)
+                printf_P("%u+: %u\n", i * LATENCY_BUCKET_TICKS,
+                         histogram.buckets[i]);
+            else
+                printf_P("%u-%u: %u  ", i * LATENCY_BUCKET_TICKS,
+                         (i + 1) * LATENCY_BUCKET_TICKS - 1,
+                         histogram.buckets[i]);
+        }
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ latency_monitor.h
+ Classic Invaders
+
+ Copyright (c) 2013, Todd Steinackle, Simon Que
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the documentation and/or other
+ materials provided with the distribution.
+
+ * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)  nor the names of
+ its contributors may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef LATENCY_MONITOR_H
+#define LATENCY_MONITOR_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Define this to measure how long key presses take to show up on screen.
+//#define LATENCY_MONITOR
+
+// Latencies are counted in buckets of this many ticks.  The last bucket also
+// counts everything longer.
+#define LATENCY_BUCKET_TICKS              8
+#define LATENCY_NUM_BUCKETS               8
+
+// What is being measured, from key press to video controller write.
+enum LatencyType {
+    LATENCY_MOVE,       // Left or right, to the player sprite moving.
+    LATENCY_FIRE,       // Fire, to the new shot's sprite being drawn.
+    NUM_LATENCY_TYPES,
+};
+
+// Measures the time from a key press, as timestamped by System::poll_keys(),
+// until the game writes the result to the video controller.  Keeps a histogram
+// of the latencies of each LatencyType, to show the effect of changes to frame
+// timing.
+class LatencyMonitor {
+  private:
+    struct Histogram {
+        uint16_t buckets[LATENCY_NUM_BUCKETS];
+        uint16_t count;
+        uint16_t max;
+        uint32_t total;
+    };
+    Histogram histograms[NUM_LATENCY_TYPES];
+
+    // Key press time of the measurement in progress for each LatencyType.
+    uint32_t start_times[NUM_LATENCY_TYPES];
+    // Bit N is set if a measurement of LatencyType N is in progress.
+    uint8_t measuring;
+
+  public:
+    LatencyMonitor() {
+        reset();
+    }
+
+    void reset() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    // Starts measuring |type| from a key press at |time|, unless it is
+    // already being measured.  Returns true if it started.
+    bool start(LatencyType type, uint32_t time) {
+        if (measuring & (1 << type))
+            return false;
+        start_times[type] = time;
+        measuring |= (1 << type);
+        return true;
+    }
+
+    // Stops measuring |type| without recording anything, e.g. if the key was
+    // released before it had any effect.
+    void cancel(LatencyType type) {
+        measuring &= ~(1 << type);
+    }
+
+    // Records the time since start() if |type| is being measured.  Call this
+    // right after the result of the key press has been drawn.
+    void end(LatencyType type);
+
+    // Reports and resets the stats of the previous wave, if there was one.
+    void new_wave(int wave);
+
+    // Prints the latency histograms.
+    void report();
+};
+
+#endif  // LATENCY_MONITOR_H
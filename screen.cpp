@@ -38,14 +38,28 @@
 
 #include "game_entity.h"
 #include "printf.h"
-
-// TODO: This should be included from a ChronoCube library file.
-#define MAX_NUM_SPRITES      128
+#include "system.h"
 
 #define DEFAULT_COLOR_KEY   0xff
 
 #define SPRITE_LAYER_INDEX     3
 
+// Indicates an entity slot without a hardware sprite.
+#define NO_HARDWARE_SPRITE  0xff
+
+// Frame sync.  The frame period is kept as a fixed point number of ticks with
+// this many fractional bits.
+#define FRAME_PERIOD_SHIFT            4
+// Start reading the status register this many ticks before the predicted
+// vertical blank, to allow for the tick resolution and for drift.
+#define VBLANK_POLL_MARGIN            2
+// A vertical blank older than this is too old to predict from, in ticks.
+#define MAX_VBLANK_PREDICTION_TIME 1000
+// Measurements spanning more frames than this are not used for the period.
+#define MAX_FRAMES_PER_MEASUREMENT    4
+// Each measurement moves the frame period 1/2^N of the way toward it.
+#define FRAME_PERIOD_AVERAGE_SHIFT    3
+
 extern uint16_t g_vram_offsets[];
 
 namespace {
@@ -58,6 +72,27 @@ namespace {
         SPRITE_DIMENSION_64,
     };
 
+    // Wrappers around video controller writes that count them by category.
+    void write_word(VideoWriteCategory category, uint16_t addr,
+                    uint16_t value) {
+#ifdef EVENT_COUNTER
+        event_counter.do_video_write(category, sizeof(value));
+#else
+        (void)category;
+#endif
+        DC.Core.writeWord(addr, value);
+    }
+
+    void write_data(VideoWriteCategory category, uint16_t addr,
+                    const void* data, uint16_t size) {
+#ifdef EVENT_COUNTER
+        event_counter.do_video_write(category, size);
+#else
+        (void)category;
+#endif
+        DC.Core.writeData(addr, data, size);
+    }
+
     // Gets the sprite dimension code for a given dimension that is one of:
     // 8, 16, 32, 64.
     // If it doesn't match any of these, returns the code for 8.
@@ -78,80 +113,171 @@ namespace {
 }
 
 namespace Graphics {
-    Screen::Screen() : allocated_vram_size(0) {}
+    Screen::Screen() : allocated_vram_size(0),
+                       last_vblank_time(0),
+                       frame_period(FRAME_PERIOD_TICKS << FRAME_PERIOD_SHIFT),
+                       vblank_time_valid(false),
+                       vblank_time_measured(false),
+                       idle_task(NULL),
+                       idle_task_context(NULL) {}
 
     bool Screen::init() {
         memset(num_sprites_per_type, 0, sizeof(num_sprites_per_type));
         memset(sprite_index_bases, 0, sizeof(sprite_index_bases));
+        memset(hardware_sprites, NO_HARDWARE_SPRITE, sizeof(hardware_sprites));
+        memset(free_hardware_sprites, 0xff, sizeof(free_hardware_sprites));
 
-        DC.Core.writeWord(REG_SPRITE_Z, SPRITE_LAYER_INDEX);
+        write_word(VIDEO_WRITE_CONTROL, REG_SPRITE_Z, SPRITE_LAYER_INDEX);
 
         // Disable all tilemap layers.
         for (int i = 0; i < NUM_TILEMAPS; ++i)
-          DC.Core.writeWord(TILE_LAYER_REG(i, TILE_CTRL_0), 0);
+          write_word(VIDEO_WRITE_CONTROL, TILE_LAYER_REG(i, TILE_CTRL_0), 0);
 
         return true;
     }
 
     void Screen::begin_update() {
+#ifndef SIMULATION_RUNNER
+        uint32_t elapsed = System::get_ticks() - last_vblank_time;
+        // Set if the vertical blank found by the last call may still be going
+        // on.  Then a new one has to begin before the screen can be updated.
+        bool same_vblank = false;
+        if (vblank_time_valid && elapsed < MAX_VBLANK_PREDICTION_TIME) {
+            uint32_t elapsed_fraction = elapsed << FRAME_PERIOD_SHIFT;
+            uint32_t num_frames = elapsed_fraction / frame_period;
+            uint16_t phase = elapsed_fraction % frame_period;
+            same_vblank = (elapsed_fraction < frame_period / 2);
+
+            // Unless one may be due right now, do idle work or sleep until
+            // shortly before the next vertical blank.
+            if (num_frames == 0 ||
+                phase > (VBLANK_POLL_MARGIN << FRAME_PERIOD_SHIFT)) {
+                uint32_t poll_time =
+                    last_vblank_time +
+                    (((num_frames + 1) * frame_period) >> FRAME_PERIOD_SHIFT) -
+                    VBLANK_POLL_MARGIN;
+                while ((int32_t)(System::get_ticks() - poll_time) < 0) {
+                    // Read the keys while waiting, so they are sampled more
+                    // than once per frame.
+                    System::poll_keys();
+                    if (!idle_task || !idle_task(idle_task_context))
+                        System::sleep();
+                }
+            }
+        }
+
         // Wait for the start of vertical blank, at which point it is safe to
         // modify the contents of the video controller.
-        while (!(DC.Core.readWord(REG_OUTPUT_STATUS) & (1 << REG_VBLANK)));
+        bool saw_active_display = false;
+        while (true) {
+            if (DC.Core.readWord(REG_OUTPUT_STATUS) & (1 << REG_VBLANK)) {
+                if (saw_active_display || !same_vblank)
+                    break;
+            } else {
+                saw_active_display = true;
+            }
+            System::poll_keys();
+        }
+        record_vblank(saw_active_display);
+#endif
     }
 
     void Screen::update() {
-        // Wait for the end of vertical blank.  This is when the drawing
-        // actually begins.
-        while ((DC.Core.readWord(REG_OUTPUT_STATUS) & (1 << REG_VBLANK)));
+#ifdef SIMULATION_RUNNER
+        // Don't wait for the display.  Just pretend that a frame has passed.
+        System::advance_ticks(FRAME_PERIOD_TICKS);
+#endif
+        // No need to wait for the end of vertical blank here.  The next
+        // begin_update() knows when this one began, and waits for a new one.
+    }
+
+    void Screen::record_vblank(bool saw_start) {
+        uint32_t now = System::get_ticks();
+        uint32_t elapsed = now - last_vblank_time;
+        bool recent = vblank_time_valid &&
+                      elapsed < MAX_VBLANK_PREDICTION_TIME;
+        uint32_t elapsed_fraction = elapsed << FRAME_PERIOD_SHIFT;
+        uint32_t num_frames = recent ?
+            (elapsed_fraction + frame_period / 2) / frame_period : 0;
+
+        if (!saw_start) {
+            // The vertical blank was already going on, so when it began is not
+            // known.  Assume that it was when predicted.
+            if (num_frames > 0) {
+                last_vblank_time +=
+                    (num_frames * frame_period) >> FRAME_PERIOD_SHIFT;
+            } else {
+                last_vblank_time = now;
+            }
+            vblank_time_valid = true;
+            vblank_time_measured = false;
+            return;
+        }
+
+        // Only the time between two measured starts tells the frame period.
+        if (vblank_time_measured && num_frames > 0 &&
+            num_frames <= MAX_FRAMES_PER_MEASUREMENT) {
+            int16_t error = (int16_t)(elapsed_fraction / num_frames) -
+                            (int16_t)frame_period;
+            frame_period += error / (1 << FRAME_PERIOD_AVERAGE_SHIFT);
+        }
+        last_vblank_time = now;
+        vblank_time_valid = true;
+        vblank_time_measured = true;
     }
 
     void Screen::allocate_sprites(const int* num_objects_per_type) {
         // Disable all sprites first.
         for (int i = 0; i < MAX_NUM_SPRITES; ++i) {
-            DC.Core.writeWord(SPRITE_REG(i, SPRITE_CTRL_0), 0);
+            write_word(VIDEO_WRITE_SPRITE, SPRITE_REG(i, SPRITE_CTRL_0), 0);
         }
+        memset(hardware_sprites, NO_HARDWARE_SPRITE, sizeof(hardware_sprites));
+        memset(free_hardware_sprites, 0xff, sizeof(free_hardware_sprites));
 
         uint16_t sprite_index = 0;
         for (int type = 0; type < NUM_GAME_ENTITY_TYPES; ++type) {
             int num_objects_of_type = num_objects_per_type[type];
 
             // Make sure there's enough room for these sprites.
-            if (sprite_index + num_objects_of_type >= MAX_NUM_SPRITES) {
+            if (sprite_index + num_objects_of_type > MAX_NUM_SPRITE_ENTITIES) {
                 printf_P("Attempted to allocate too many sprites: %d\n",
                          sprite_index);
                 break;
             }
 
             // Store the number of sprites and first sprite index for each type.
+            // Hardware sprites are assigned later, as the objects are drawn.
             num_sprites_per_type[type] = num_objects_of_type;
             sprite_index_bases[type] = sprite_index;
             printf_P("Allocated %u sprites starting at %u for object type %d\n",
                      num_objects_of_type, sprite_index, type);
+            sprite_index += num_objects_of_type;
+        }
+    }
 
-            if (num_objects_of_type == 0)
+    uint8_t Screen::alloc_hardware_sprite() {
+        for (uint8_t i = 0; i < sizeof(free_hardware_sprites); ++i) {
+            uint8_t free_bits = free_hardware_sprites[i];
+            if (!free_bits)
                 continue;
-
-            const GameEntities::GameEntityTypeProperties* properties =
-                GameEntities::GameEntity::get_type_property(type);
-
-            uint8_t sprite_w = get_sprite_dimension(properties->sprite_w);
-            uint8_t sprite_h = get_sprite_dimension(properties->sprite_h);
-            // Initialize each sprite's dimensions, color key, and data offset.
-            for (int i = 0; i < num_objects_of_type; ++i, ++sprite_index) {
-                DC.Core.writeWord(SPRITE_REG(sprite_index, SPRITE_CTRL_1),
-                                  (sprite_w << SPRITE_HSIZE_0) |
-                                  (sprite_h << SPRITE_VSIZE_0));
-                DC.Core.writeWord(SPRITE_REG(sprite_index, SPRITE_COLOR_KEY),
-                                  DEFAULT_COLOR_KEY);
-                DC.Core.writeWord(SPRITE_REG(sprite_index, SPRITE_DATA_OFFSET),
-                                  get_image_offset(type));
-            }
+            uint8_t bit = 0;
+            while (!(free_bits & (1 << bit)))
+                ++bit;
+            free_hardware_sprites[i] &= ~(1 << bit);
+            return i * 8 + bit;
         }
+        return NO_HARDWARE_SPRITE;
+    }
+
+    void Screen::free_hardware_sprite(uint8_t sprite_index) {
+        write_word(VIDEO_WRITE_SPRITE, SPRITE_REG(sprite_index, SPRITE_CTRL_0),
+                   0);
+        free_hardware_sprites[sprite_index / 8] |= (1 << (sprite_index % 8));
     }
 
     void Screen::set_palette_data(uint8_t palette, const void* palette_data,
                                   uint16_t size) {
-        DC.Core.writeData(PALETTE(palette), palette_data, size);
+        write_data(VIDEO_WRITE_PALETTE, PALETTE(palette), palette_data, size);
     }
 
     void Screen::set_palette_entry(uint8_t palette, uint8_t entry,
@@ -166,8 +292,9 @@ namespace Graphics {
         palette_entry.g = g;
         palette_entry.b = b;
         palette_entry.padding = 0;
-        DC.Core.writeData(PALETTE(palette) + sizeof(palette_entry) * entry,
-                          &palette_entry, sizeof(palette_entry));
+        write_data(VIDEO_WRITE_PALETTE,
+                   PALETTE(palette) + sizeof(palette_entry) * entry,
+                   &palette_entry, sizeof(palette_entry));
     }
 
     void Screen::setup_tile_layer(uint8_t layer, bool enabled, uint8_t palette,
@@ -178,22 +305,27 @@ namespace Graphics {
             (1 << TILE_ENABLE_TRANSP) |
             (1 << TILE_ENABLE_FLIP) |
             (palette << TILE_PALETTE_START);
-        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_CTRL_0), tile_ctrl0_value);
-        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_DATA_OFFSET), data_offset);
-        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_EMPTY_VALUE), 0);
-        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_COLOR_KEY), color_key);
+        write_word(VIDEO_WRITE_CONTROL, TILE_LAYER_REG(layer, TILE_CTRL_0),
+                   tile_ctrl0_value);
+        write_word(VIDEO_WRITE_CONTROL, TILE_LAYER_REG(layer, TILE_DATA_OFFSET),
+                   data_offset);
+        write_word(VIDEO_WRITE_CONTROL, TILE_LAYER_REG(layer, TILE_EMPTY_VALUE),
+                   0);
+        write_word(VIDEO_WRITE_CONTROL, TILE_LAYER_REG(layer, TILE_COLOR_KEY),
+                   color_key);
     }
 
     void Screen::scroll_tile_layer(uint8_t layer, int16_t x, int16_t y) {
-        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_OFFSET_X), x);
-        DC.Core.writeWord(TILE_LAYER_REG(layer, TILE_OFFSET_Y), y);
+        write_word(VIDEO_WRITE_SCROLL, TILE_LAYER_REG(layer, TILE_OFFSET_X), x);
+        write_word(VIDEO_WRITE_SCROLL, TILE_LAYER_REG(layer, TILE_OFFSET_Y), y);
     }
 
     void Screen::set_tilemap_data(uint8_t layer, uint8_t x, uint8_t y,
                                   const void* tilemap_data, uint16_t size) {
 #define TILEMAP_WIDTH     32
         uint16_t offset = (x + y * TILEMAP_WIDTH) * sizeof(uint16_t);
-        DC.Core.writeData(TILEMAP(layer) + offset, tilemap_data, size);
+        write_data(VIDEO_WRITE_TILEMAP, TILEMAP(layer) + offset, tilemap_data,
+                   size);
 #undef TILEMAP_WIDTH;
     }
 
@@ -201,29 +333,65 @@ namespace Graphics {
         return g_vram_offsets[type];
     }
 
-    void Screen::update_sprite(const GameEntities::GameEntity* object) {
+    bool Screen::update_sprite(const GameEntities::GameEntity* object,
+                               uint8_t fields) {
         uint8_t type = object->get_type();
         if (num_sprites_per_type[type] == 0)
-            return;
-        uint8_t index = object->get_index();
-
-        int x = object->get_x();
-        int y = object->get_y();
+            return true;
+        uint8_t& sprite_index =
+            hardware_sprites[sprite_index_bases[type] + object->get_index()];
+
+        // Dead objects are not shown, so give up their hardware sprites.
+        if (!object->is_alive()) {
+            if (sprite_index != NO_HARDWARE_SPRITE) {
+                free_hardware_sprite(sprite_index);
+                sprite_index = NO_HARDWARE_SPRITE;
+            }
+            return true;
+        }
 
         const GameEntities::GameEntityTypeProperties* properties =
             GameEntities::GameEntity::get_type_property(type);
         uint8_t sprite_w = properties->sprite_w;
         uint8_t sprite_h = properties->sprite_h;
-        uint16_t offset = get_image_offset(type) +
-                (sprite_w * sprite_h) * object->get_current_image();
-        uint16_t sprite_index = sprite_index_bases[type] + index;
-        DC.Core.writeWord(SPRITE_REG(sprite_index, SPRITE_CTRL_0),
-                          object->is_alive() |
-                          (1 << SPRITE_ENABLE_TRANSP));
-        DC.Core.writeWord(SPRITE_REG(sprite_index, SPRITE_DATA_OFFSET), offset);
-        // TODO: this needs to be faster.
-        DC.Core.writeWord(SPRITE_REG(sprite_index, SPRITE_OFFSET_X), x);
-        DC.Core.writeWord(SPRITE_REG(sprite_index, SPRITE_OFFSET_Y), y);
+
+        if (sprite_index == NO_HARDWARE_SPRITE) {
+            sprite_index = alloc_hardware_sprite();
+            // If all the hardware sprites are in use, this object doesn't get
+            // drawn.  It will try again the next time it is drawn.
+            if (sprite_index == NO_HARDWARE_SPRITE)
+                return false;
+
+            // Initialize the sprite's dimensions and color key, and enable
+            // it.  It stays enabled until it is freed.
+            write_word(VIDEO_WRITE_SPRITE,
+                       SPRITE_REG(sprite_index, SPRITE_CTRL_1),
+                       (get_sprite_dimension(sprite_w) << SPRITE_HSIZE_0) |
+                       (get_sprite_dimension(sprite_h) << SPRITE_VSIZE_0));
+            write_word(VIDEO_WRITE_SPRITE,
+                       SPRITE_REG(sprite_index, SPRITE_COLOR_KEY),
+                       DEFAULT_COLOR_KEY);
+            write_word(VIDEO_WRITE_SPRITE,
+                       SPRITE_REG(sprite_index, SPRITE_CTRL_0),
+                       1 | (1 << SPRITE_ENABLE_TRANSP));
+            fields = SPRITE_UPDATE_ALL;
+        }
+
+        if (fields & SPRITE_UPDATE_IMAGE) {
+            uint16_t offset = get_image_offset(type) +
+                    (sprite_w * sprite_h) * object->get_current_image();
+            write_word(VIDEO_WRITE_SPRITE,
+                       SPRITE_REG(sprite_index, SPRITE_DATA_OFFSET), offset);
+        }
+        if (fields & SPRITE_UPDATE_POSITION) {
+            write_word(VIDEO_WRITE_SPRITE,
+                       SPRITE_REG(sprite_index, SPRITE_OFFSET_X),
+                       object->get_x());
+            write_word(VIDEO_WRITE_SPRITE,
+                       SPRITE_REG(sprite_index, SPRITE_OFFSET_Y),
+                       object->get_y());
+        }
+        return true;
     }
 
 }
@@ -44,37 +44,102 @@
 #define max_updates   360
 #define SCREEN_TILE_SIZE           16
 
+// TODO: This should be included from a ChronoCube library file.
+#define MAX_NUM_SPRITES           128
+
+// Maximum number of entities that can have sprites.  Only the ones that are
+// alive at the same time need hardware sprites, so this can be more than
+// MAX_NUM_SPRITES.
+#define MAX_NUM_SPRITE_ENTITIES   160
+
+// Approximate time between vertical blanks, in system ticks.
+#define FRAME_PERIOD_TICKS         17
+
 namespace GameEntities {
 class GameEntity;
 }  // namespace GameEntities
 
 namespace Graphics {
 
+    // Which parts of a sprite Screen::update_sprite() should rewrite.
+    enum {
+        SPRITE_UPDATE_POSITION = (1 << 0),
+        SPRITE_UPDATE_IMAGE    = (1 << 1),
+        SPRITE_UPDATE_ALL      = SPRITE_UPDATE_POSITION | SPRITE_UPDATE_IMAGE,
+    };
+
     class Screen {
+    public:
+        // Work that begin_update() can do while it waits for the display.  It
+        // must not touch the video controller, and should take no more than a
+        // tick or so.  Returns true if there is more to do, or false to let
+        // the system sleep until the next tick.
+        typedef bool (*IdleTask)(void* context);
+
     private:
-        // Each entry in the array is the starting sprite index for each type of
+        // Each entry in the array is the starting entity slot for each type of
         // game entity.
-        // e.g. for the k-th object of type=N, the sprite index is:
+        // e.g. for the k-th object of type=N, the entity slot is:
         //        |sprite_index_bases[type] + k|.
         uint8_t sprite_index_bases[NUM_GAME_ENTITY_TYPES];
-        // How many sprites are allocated for each type.
+        // How many entity slots are allocated for each type.
         uint8_t num_sprites_per_type[NUM_GAME_ENTITY_TYPES];
 
+        // The hardware sprite currently used by each entity slot, or
+        // NO_HARDWARE_SPRITE.  Hardware sprites are assigned when an entity is
+        // drawn alive and released when it is drawn dead, so dead aliens and
+        // inactive shots do not hold on to them.
+        uint8_t hardware_sprites[MAX_NUM_SPRITE_ENTITIES];
+        // Bitmask of unused hardware sprites.
+        uint8_t free_hardware_sprites[MAX_NUM_SPRITES / 8];
+
+        // Returns an unused hardware sprite, or NO_HARDWARE_SPRITE if there
+        // are none left.
+        uint8_t alloc_hardware_sprite();
+        void free_hardware_sprite(uint8_t sprite_index);
+
         // For VRAM allocation.
         uint32_t allocated_vram_size;
 
+        // Frame sync.  The next vertical blank is predicted from the time of
+        // the last one and the measured frame period, so that the status
+        // register only has to be read shortly before it.
+        uint32_t last_vblank_time;
+        // Time between vertical blanks, in 1/16 ticks.
+        uint16_t frame_period;
+        // Whether |last_vblank_time| can be used for predictions at all, and
+        // whether it was measured at the start of the vertical blank or only
+        // predicted.
+        bool vblank_time_valid;
+        bool vblank_time_measured;
+        IdleTask idle_task;
+        void* idle_task_context;
+
+        // Updates the frame sync state after finding a vertical blank.
+        // |saw_start| is set if the vertical blank began while polling.
+        void record_vblank(bool saw_start);
+
     public:
         Screen();
 
         // Initialize video screen.  Returns true on success.
         bool init();
 
-        // Wait for the screen to be ready for updates.
+        // Wait for the screen to be ready for updates.  Until the next
+        // vertical blank is due, runs the idle task or sleeps instead of
+        // reading the video controller.
         void begin_update();
 
         // Redraw the entire screen, including all the scheduled blits.
         void update();
 
+        // Sets the task run by begin_update() while waiting.  Pass NULL to
+        // clear it.
+        void set_idle_task(IdleTask task, void* context) {
+            idle_task = task;
+            idle_task_context = context;
+        }
+
         // Used to initialize the sprite allocation table based on how many
         // of each type of object will be drawn.
         void allocate_sprites(const int* num_objects_per_type);
@@ -103,7 +168,12 @@ namespace Graphics {
         uint16_t get_image_offset(int type) const;
 
         // Updates a sprite in the sprite table given an updated entity object.
-        void update_sprite(const GameEntities::GameEntity* object);
+        // |fields| is a combination of SPRITE_UPDATE_* values.  It is ignored
+        // when the object is dead or has just been given a hardware sprite.
+        // Returns false if all hardware sprites are in use, so the object could
+        // not be drawn.
+        bool update_sprite(const GameEntities::GameEntity* object,
+                           uint8_t fields = SPRITE_UPDATE_ALL);
     };
 
 }  // namespace Graphics
@@ -39,26 +39,27 @@
 
 namespace Game {
 
-    // Clear everything when this is created.
-    ShieldGroupTiles::ShieldGroupTiles() {
-        for (uint8_t i = 0; i < SHIELD_GROUP_HEIGHT / 2; ++i) {
-            memset(rows[i].map_buffer, 0, sizeof(rows[i].map_buffer));
-            rows[i].dirty = 0;
-        }
+    // Mark everything dirty when this is created, so the entire tilemap gets
+    // drawn the first time.
+    ShieldTiles::ShieldTiles() {
+        memset(map_buffer, 0, sizeof(map_buffer));
+        dirty_tiles = (1UL << NUM_SHIELD_TILES) - 1;
+        first_group = 0;
     }
 
-    void ShieldGroupTiles::init(const ShieldPiece* shields) {
-        for (int i = 0; i < SHIELD_GROUP_WIDTH * SHIELD_GROUP_HEIGHT; ++i)
+    void ShieldTiles::init(const ShieldPiece* shields) {
+        for (int i = 0; i < NUM_SHIELDS; ++i)
             update_shield_piece(shields[i]);
     }
 
-    void ShieldGroupTiles::update_shield_piece(const ShieldPiece& shield) {
+    void ShieldTiles::update_shield_piece(const ShieldPiece& shield) {
         uint8_t x = shield.x;
         uint8_t y = shield.y;
 
         // Since each tile is 2x2 shields, divide the shield x and y values by 2
         // to get the tile row and column.
-        ShieldDoubleRow& row = rows[y / 2];
+        uint8_t row = y / 2;
+        uint8_t col = x / 2;
 
         // Determine the bit within the tile value that corresponds to the
         // current shield piece being updated:
@@ -70,25 +71,68 @@ namespace Game {
         uint8_t bit_offset = (x % 2) + (y % 2) * 2;
 
         // Set or clear the bit depending on the shield state.
-        uint16_t& tile = row.map_buffer[x / 2];
+        uint16_t& tile = map_buffer[shield.group][row][col];
+        uint16_t old_tile = tile;
         if (shield.intact)
             tile |= (1 << bit_offset);
         else
             tile &= ~(1 << bit_offset);
 
-        row.dirty = true;   // Indicate that the row needs to be redrawn.
+        // Queue the tile to be redrawn.
+        if (tile != old_tile) {
+            uint8_t tile_index =
+                (shield.group * SHIELD_TILE_ROWS + row) * SHIELD_TILES_PER_ROW +
+                col;
+            dirty_tiles |= (1UL << tile_index);
+        }
     }
 
-    void ShieldGroupTiles::draw(Graphics::Screen* screen, uint8_t layer,
-                                uint8_t x, uint8_t y) {
-        for (uint8_t i = 0; i < SHIELD_GROUP_HEIGHT / 2; ++i) {
-            ShieldDoubleRow& row = rows[i];
-            if (!row.dirty)
-                continue;
-            screen->set_tilemap_data(layer, x, y + i, row.map_buffer,
-                                     sizeof(row.map_buffer));
-            // Clear the dirty bit so it doesn't get redrawn again.
-            row.dirty = false;
+    void ShieldTiles::draw(Graphics::Screen* screen, uint8_t layer,
+                           uint8_t max_writes) {
+        const uint16_t* tiles = &map_buffer[0][0][0];
+        // Start with the group after the last one that was written to, so that
+        // when the writes run out, one busy group doesn't keep the others
+        // waiting.
+        uint8_t group = first_group;
+        for (uint8_t i = 0; i < NUM_SHIELD_GROUPS; ++i) {
+            uint8_t x = group * SHIELD_GROUP_X_SPACING / SCREEN_TILE_SIZE;
+            uint8_t tile_index =
+                group * SHIELD_TILE_ROWS * SHIELD_TILES_PER_ROW;
+            for (uint8_t row = 0; row < SHIELD_TILE_ROWS; ++row) {
+                // Quickly skip rows without any dirty tiles.
+                uint32_t row_mask = ((1UL << SHIELD_TILES_PER_ROW) - 1) <<
+                                    tile_index;
+                if (!(dirty_tiles & row_mask)) {
+                    tile_index += SHIELD_TILES_PER_ROW;
+                    continue;
+                }
+
+                uint8_t col = 0;
+                while (col < SHIELD_TILES_PER_ROW) {
+                    if (!(dirty_tiles & (1UL << (tile_index + col)))) {
+                        ++col;
+                        continue;
+                    }
+                    if (max_writes == 0)
+                        return;
+
+                    // Find the end of this run of dirty tiles.
+                    uint8_t run_start = col;
+                    while (col < SHIELD_TILES_PER_ROW &&
+                           (dirty_tiles & (1UL << (tile_index + col)))) {
+                        dirty_tiles &= ~(1UL << (tile_index + col));
+                        ++col;
+                    }
+                    screen->set_tilemap_data(layer, x + run_start, row,
+                                             &tiles[tile_index + run_start],
+                                             (col - run_start) *
+                                                 sizeof(tiles[0]));
+                    --max_writes;
+                    first_group = (group + 1) % NUM_SHIELD_GROUPS;
+                }
+                tile_index += SHIELD_TILES_PER_ROW;
+            }
+            group = (group + 1) % NUM_SHIELD_GROUPS;
         }
     }
 
@@ -37,6 +37,20 @@
 
 #include "game_defs.h"
 
+// Each tile is 16x16 and represents a 2x2 cluster of shield pieces.
+#define SHIELD_TILES_PER_ROW          (SHIELD_GROUP_WIDTH / 2)
+#define SHIELD_TILE_ROWS             (SHIELD_GROUP_HEIGHT / 2)
+#define NUM_SHIELD_TILES  \
+    (NUM_SHIELD_GROUPS * SHIELD_TILE_ROWS * SHIELD_TILES_PER_ROW)
+
+// Maximum number of tilemap writes per frame when drawing normally.  Each write
+// is either a single tile or a run of adjacent tiles in the same row.
+#define SHIELD_TILE_WRITES_PER_FRAME                4
+
+#if NUM_SHIELD_TILES > 32
+#error "Too many shield tiles for the dirty tile mask."
+#endif
+
 namespace Graphics {
     class Screen;
 }
@@ -46,35 +60,40 @@ namespace Game {
     struct ShieldPiece;
     using Graphics::Screen;
 
-    // For drawing a shield group.
-    class ShieldGroupTiles {
+    // For drawing all shield groups.  Keeps a copy of the shield tile map, and
+    // a queue of the tiles that have changed since they were last copied to
+    // the video controller.
+    class ShieldTiles {
       private:
-        // For drawing two shield rows.
-        struct ShieldDoubleRow {
-            // Contains tile map data.  Every element of the array is a 16x16
-            // tile that represents a 2x2 shield cluster.  So the width is half
-            // the width of a shield group.
-            uint16_t map_buffer[SHIELD_GROUP_WIDTH / 2];
-
-            // Set this flag when the buffer is updated, and the contents need
-            // to be copied to the video controller.
-            uint8_t dirty:1;
-        } rows[SHIELD_GROUP_HEIGHT / 2];
+        // Contains tile map data, in order of group, row and column.
+        uint16_t map_buffer[NUM_SHIELD_GROUPS][SHIELD_TILE_ROWS]
+                           [SHIELD_TILES_PER_ROW];
+
+        // One bit per tile in |map_buffer|, using the same order.  Set when a
+        // tile is updated and needs to be copied to the video controller.
+        uint32_t dirty_tiles;
+
+        // Group that draw() looks at first.
+        uint8_t first_group;
 
       public:
-        ShieldGroupTiles();
+        ShieldTiles();
 
         // Initialize the tile map buffer based on a given array of shields.
+        // The array should contain the shields of all groups.
         void init(const ShieldPiece* shields);
 
-        // Updates the corresponding buffer tile bit for a shield piece.
+        // Updates the corresponding buffer tile bit for a shield piece.  If the
+        // tile value changes, queues the tile to be drawn.
         void update_shield_piece(const ShieldPiece& shield);
 
-        // Copies the tilemap buffers to the actual tilemap memory.
-        // |x| and |y| are the location in the destination tilemap corresponding
-        // to the top left of the shield group.  They are in tile coordinates,
-        // not screen pixel coordinates.
-        void draw(Screen* screen, uint8_t layer, uint8_t x, uint8_t y);
+        // Copies queued tiles to the tilemap, merging adjacent tiles in a row
+        // into one write.  Stops after |max_writes| writes, leaving the rest
+        // of the queue for later.  Each call starts with the group after the
+        // last one written, so the groups take turns when writes run out.
+        // The top left tile of the tilemap corresponds to the top left of the
+        // first shield group.
+        void draw(Screen* screen, uint8_t layer, uint8_t max_writes);
     };
 
 }  // namespace Game
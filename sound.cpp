@@ -32,13 +32,346 @@
 
 #include "sound.h"
 
+#include <string.h>
+
+#include <avr/pgmspace.h>
+
+#include "system.h"
+
+// Reads and writes of queue indices.  The acquire/release ordering makes sure
+// the queue entries are written before the index that publishes them.  On the
+// AVR these are plain byte accesses.
+#define LOAD_INDEX(index)          __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define STORE_INDEX(index, value)  \
+    __atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+
+// Don't mix more than this much in one update.  Older samples are skipped
+// instead: the voices and the march move past them without mixing them.
+#define MAX_SAMPLES_PER_UPDATE     (SOUND_BUFFER_SIZE * 2)
+// Longer gaps than this, e.g. a pause, are not caught up on.
+#define MAX_TICKS_PER_UPDATE       1000
+
+namespace {
+
+    // Scales |count| samples from |src| by |volume| and adds them to |dst|,
+    // saturating at the limits of int16_t.
+    void mix_samples(int16_t* dst, const int8_t* src, uint8_t count,
+                     uint8_t volume) {
+        // An 8-bit sample times an 8-bit volume always fits in 16 bits, so
+        // only the sum needs to be wider.
+        for (uint8_t i = 0; i < count; ++i) {
+            int32_t sample = dst[i] + (int16_t)(src[i] * volume);
+            if (sample > INT16_MAX)
+                sample = INT16_MAX;
+            else if (sample < INT16_MIN)
+                sample = INT16_MIN;
+            dst[i] = sample;
+        }
+    }
+
+}  // namespace
+
 namespace Sound {
 
-    Sound::Sound()
+    Sound::Sound() : clips(NULL),
+                     march_effect(0),
+                     march_interval(0),
+                     march_countdown(0),
+                     march_note(0),
+                     command_head(0),
+                     command_tail(0),
+                     buffer_head(0),
+                     buffer_tail(0),
+                     sample_time_remainder(0)
     {
+        memset(voices, 0, sizeof(voices));
+        last_update_time = System::get_ticks();
     }
     Sound::~Sound()
     {
     }
 
+    void Sound::set_clips(const SoundClip* clips)
+    {
+        this->clips = clips;
+    }
+
+    void Sound::play(Effect effect, uint8_t volume)
+    {
+        push_command(COMMAND_PLAY, effect, volume);
+    }
+
+    void Sound::play_loop(Effect effect, uint8_t volume)
+    {
+        push_command(COMMAND_PLAY_LOOP, effect, volume);
+    }
+
+    void Sound::halt(Effect effect)
+    {
+        push_command(COMMAND_HALT, effect, 0);
+    }
+
+    void Sound::halt_all()
+    {
+        push_command(COMMAND_HALT_ALL, 0, 0);
+    }
+
+    void Sound::set_march(Effect effect, uint16_t interval)
+    {
+        push_command(COMMAND_SET_MARCH, effect, interval);
+    }
+
+    void Sound::update()
+    {
+        update(System::get_ticks() - last_update_time);
+    }
+
+    void Sound::update(uint32_t elapsed_time)
+    {
+        // Apply the queued commands.
+        uint8_t head = LOAD_INDEX(command_head);
+        uint8_t tail = command_tail;
+        while (tail != head) {
+            run_command(commands[tail % SOUND_COMMAND_QUEUE_SIZE]);
+            ++tail;
+        }
+        STORE_INDEX(command_tail, tail);
+
+        // Work out how many samples have to be mixed to cover
+        // |elapsed_time|.
+        if (elapsed_time > MAX_TICKS_PER_UPDATE)
+            elapsed_time = MAX_TICKS_PER_UPDATE;
+        uint32_t sample_time = elapsed_time * SOUND_SAMPLE_RATE +
+                               sample_time_remainder;
+        last_update_time = System::get_ticks();
+        uint32_t num_samples = sample_time / 1000;
+        sample_time_remainder = sample_time % 1000;
+        if (num_samples > MAX_SAMPLES_PER_UPDATE) {
+            mix(NULL, num_samples - MAX_SAMPLES_PER_UPDATE);
+            num_samples = MAX_SAMPLES_PER_UPDATE;
+        }
+
+        while (num_samples > 0) {
+            int16_t chunk[SOUND_MIX_CHUNK_SIZE];
+            uint8_t count = SOUND_MIX_CHUNK_SIZE;
+            if (num_samples < count)
+                count = num_samples;
+            mix(chunk, count);
+            num_samples -= count;
+
+            uint8_t buffer_head_now = buffer_head;
+            uint8_t space = SOUND_BUFFER_SIZE -
+                            (uint8_t)(buffer_head_now - LOAD_INDEX(buffer_tail));
+            if (count > space)
+                count = space;
+            for (uint8_t i = 0; i < count; ++i, ++buffer_head_now)
+                buffer[buffer_head_now % SOUND_BUFFER_SIZE] = chunk[i];
+            STORE_INDEX(buffer_head, buffer_head_now);
+        }
+    }
+
+    void Sound::wait_for_all_to_finish()
+    {
+        // Make sure any sounds that were just started are counted.
+        update();
+        while (has_unlooped_voices()) {
+            System::delay(1);
+            update();
+        }
+    }
+
+    uint16_t Sound::read_samples(int16_t* samples, uint16_t max_samples)
+    {
+        uint8_t head = LOAD_INDEX(buffer_head);
+        uint8_t tail = buffer_tail;
+        uint16_t count = 0;
+        while (tail != head && count < max_samples) {
+            samples[count++] = buffer[tail % SOUND_BUFFER_SIZE];
+            ++tail;
+        }
+        STORE_INDEX(buffer_tail, tail);
+        return count;
+    }
+
+    void Sound::push_command(uint8_t type, uint8_t effect, uint16_t value)
+    {
+        uint8_t head = command_head;
+        if ((uint8_t)(head - LOAD_INDEX(command_tail)) >=
+                SOUND_COMMAND_QUEUE_SIZE) {
+            return;
+        }
+        Command& command = commands[head % SOUND_COMMAND_QUEUE_SIZE];
+        command.type = type;
+        command.effect = effect;
+        command.value = value;
+        STORE_INDEX(command_head, (uint8_t)(head + 1));
+    }
+
+    void Sound::run_command(const Command& command)
+    {
+        switch (command.type) {
+        case COMMAND_PLAY:
+            start_voice(command.effect, command.value, false);
+            break;
+        case COMMAND_PLAY_LOOP:
+            for (uint8_t i = 0; i < SOUND_NUM_VOICES; ++i) {
+                if (voices[i].data && voices[i].effect == command.effect)
+                    return;
+            }
+            start_voice(command.effect, command.value, true);
+            break;
+        case COMMAND_HALT:
+            for (uint8_t i = 0; i < SOUND_NUM_VOICES; ++i) {
+                if (voices[i].effect == command.effect)
+                    voices[i].data = NULL;
+            }
+            if (march_effect == command.effect) {
+                stop_march_notes();
+                march_interval = 0;
+            }
+            break;
+        case COMMAND_HALT_ALL:
+            for (uint8_t i = 0; i < SOUND_NUM_VOICES; ++i)
+                voices[i].data = NULL;
+            march_interval = 0;
+            break;
+        case COMMAND_SET_MARCH:
+            // Start with a beat if the march was not already playing.
+            if (!march_interval || march_effect != command.effect) {
+                march_countdown = 0;
+                march_note = 0;
+            } else if (march_countdown > command.value)
+                march_countdown = command.value;
+            march_effect = command.effect;
+            march_interval = command.value;
+            break;
+        }
+    }
+
+    void Sound::start_voice(uint8_t effect, uint8_t volume, bool loop)
+    {
+        if (!clips || effect >= NUM_SOUND_EFFECTS)
+            return;
+        SoundClip clip;
+        memcpy_P(&clip, &clips[effect], sizeof(clip));
+        if (!clip.data || clip.length == 0)
+            return;
+
+        // Use a free voice.  If there are none, replace the one that has
+        // played the longest, but not a looping one.
+        Voice* voice = NULL;
+        for (uint8_t i = 0; i < SOUND_NUM_VOICES; ++i) {
+            Voice& candidate = voices[i];
+            if (!candidate.data) {
+                voice = &candidate;
+                break;
+            }
+            if (!candidate.loop &&
+                (!voice || candidate.position > voice->position)) {
+                voice = &candidate;
+            }
+        }
+        if (!voice)
+            return;
+
+        voice->data = clip.data;
+        voice->length = clip.length;
+        voice->position = 0;
+        voice->effect = effect;
+        voice->volume = volume;
+        voice->loop = loop;
+    }
+
+    void Sound::stop_march_notes()
+    {
+        for (uint8_t i = 0; i < SOUND_NUM_VOICES; ++i) {
+            if (voices[i].effect >= march_effect &&
+                voices[i].effect < march_effect + SOUND_MARCH_NUM_NOTES) {
+                voices[i].data = NULL;
+            }
+        }
+    }
+
+    void Sound::mix(int16_t* samples, uint16_t count)
+    {
+        // Split the mix at each beat, so the beat starts on the right sample.
+        while (count > 0) {
+            if (march_interval && march_countdown == 0) {
+                stop_march_notes();
+                start_voice(march_effect + march_note, SOUND_DEFAULT_VOLUME,
+                            false);
+                march_note = (march_note + 1) % SOUND_MARCH_NUM_NOTES;
+                march_countdown = march_interval;
+            }
+            uint16_t num_to_mix = count;
+            if (march_interval && march_countdown < num_to_mix)
+                num_to_mix = march_countdown;
+            if (samples) {
+                mix_voices(samples, num_to_mix);
+                samples += num_to_mix;
+            } else {
+                skip_voices(num_to_mix);
+            }
+            count -= num_to_mix;
+            if (march_interval)
+                march_countdown -= num_to_mix;
+        }
+    }
+
+    void Sound::mix_voices(int16_t* samples, uint8_t count)
+    {
+        memset(samples, 0, count * sizeof(samples[0]));
+        for (uint8_t i = 0; i < SOUND_NUM_VOICES; ++i) {
+            Voice& voice = voices[i];
+            uint8_t num_mixed = 0;
+            while (voice.data && num_mixed < count) {
+                uint8_t num_to_mix = count - num_mixed;
+                if (voice.length - voice.position < num_to_mix)
+                    num_to_mix = voice.length - voice.position;
+
+                // The samples may be in program memory, so copy them out
+                // first.
+                int8_t voice_samples[SOUND_MIX_CHUNK_SIZE];
+                memcpy_P(voice_samples, voice.data + voice.position,
+                         num_to_mix);
+                mix_samples(samples + num_mixed, voice_samples, num_to_mix,
+                            voice.volume);
+
+                num_mixed += num_to_mix;
+                voice.position += num_to_mix;
+                if (voice.position == voice.length) {
+                    if (voice.loop)
+                        voice.position = 0;
+                    else
+                        voice.data = NULL;
+                }
+            }
+        }
+    }
+
+    void Sound::skip_voices(uint16_t count)
+    {
+        for (uint8_t i = 0; i < SOUND_NUM_VOICES; ++i) {
+            Voice& voice = voices[i];
+            if (!voice.data)
+                continue;
+            if (voice.loop)
+                voice.position = (voice.position + (uint32_t)count) %
+                                 voice.length;
+            else if (voice.length - voice.position <= count)
+                voice.data = NULL;
+            else
+                voice.position += count;
+        }
+    }
+
+    bool Sound::has_unlooped_voices() const
+    {
+        for (uint8_t i = 0; i < SOUND_NUM_VOICES; ++i) {
+            if (voices[i].data && !voices[i].loop)
+                return true;
+        }
+        return false;
+    }
+
 }
@@ -33,15 +33,162 @@
 #ifndef SOUND_H
 #define SOUND_H
 
+#include <stdint.h>
+
+// Build with the clips from sound_data.h.  It is not checked in, since it is
+// generated from the .ogg files in data/ by:
+//   tools/gen_sound_pack.py --header sound_data.h
+// The clips are read through 16-bit pointers, so the tool keeps them small
+// enough to stay in the low 64 KB of flash.
+//#define SOUND_DATA
+
+// Output sample rate, in Hz.
+#define SOUND_SAMPLE_RATE               8000
+// Number of sounds that can play at the same time.  The game seldom has more
+// than a march note, a shot, an explosion and the bonus ship going at once, and
+// each voice takes RAM, so this is less than a desktop mixer would have.  When
+// all are busy, a new sound replaces the oldest one that isn't looping.
+#define SOUND_NUM_VOICES                   4
+
+// These must be powers of two, no larger than 128.
+#define SOUND_COMMAND_QUEUE_SIZE          16
+#define SOUND_BUFFER_SIZE                128
+
+// Number of samples mixed at a time.
+#define SOUND_MIX_CHUNK_SIZE              32
+// Each voice's 8-bit samples are multiplied by its volume when mixed.  Voices
+// that add up to more than 16 bits saturate instead of wrapping around.
+#define SOUND_DEFAULT_VOLUME             128
+
+// The march plays this many notes in turn, one per beat.  They are the effects
+// that follow the one passed to Sound::set_march().
+#define SOUND_MARCH_NUM_NOTES              4
+
 namespace Sound {
 
+    enum Effect { SHOT, EXPLOSION, ALIEN_DEATH, FREE_GUY, GAME_OVER, START_WAVE, BIG_BONUS, SMALL_BONUS, SHOT_COLLISION,
+            ACTIVE_BONUS, START_SCREEN, PLAYER_DEAD, PLAYER_REBIRTH, ALIENS_LANDED, END_WAVE, MENU_SELECT, ZAP_SCORES,
+            NEW_HIGH_SCORE, ABOUT_SCREEN, WRONG_KEY, HELP_SCREEN, EXIT, BG, BG_4, BG_3, BG_2, BG_1,
+            MARCH_1, MARCH_2, MARCH_3, MARCH_4,
+            NUM_SOUND_EFFECTS };
+
+    // The sound data of one effect: signed 8-bit mono samples at
+    // SOUND_SAMPLE_RATE.  On the AVR, the clips and the samples they point to
+    // are in program memory.
+    struct SoundClip {
+        const int8_t* data;
+        uint16_t length;
+    };
+
+    // Mixes sound effects into a buffer of 16-bit samples, to be read by an
+    // audio output.
+    //
+    // The game tells the mixer what to play through a command queue, so that
+    // it never has to wait for the mixer, even if the mixer runs elsewhere.
+    // The mixed samples are passed to the output through a ring buffer.  Both
+    // have a single reader and a single writer and need no locking.
     class Sound {
-        enum { SHOT, EXPLOSION, ALIEN_DEATH, FREE_GUY, GAME_OVER, START_WAVE, BIG_BONUS, SMALL_BONUS, SHOT_COLLISION,
-                ACTIVE_BONUS, START_SCREEN, PLAYER_DEAD, PLAYER_REBIRTH, ALIENS_LANDED, END_WAVE, MENU_SELECT, ZAP_SCORES,
-                NEW_HIGH_SCORE, ABOUT_SCREEN, WRONG_KEY, HELP_SCREEN, EXIT, BG, BG_4, BG_3, BG_2, BG_1 };
     public:
         Sound();
         ~Sound();
+
+        // Sets the table of clips, indexed by Effect.  Nothing plays until
+        // this is set.
+        void set_clips(const SoundClip* clips);
+
+        // These queue a command for the mixer.  If the queue is full, the
+        // command is dropped.
+        // Plays an effect once.
+        void play(Effect effect, uint8_t volume = SOUND_DEFAULT_VOLUME);
+        // Plays an effect over and over, unless it is already playing.
+        void play_loop(Effect effect, uint8_t volume = SOUND_DEFAULT_VOLUME);
+        void halt(Effect effect);
+        void halt_all();
+        // Plays a beat every |interval| samples, cutting off the previous
+        // one.  The beats go through the SOUND_MARCH_NUM_NOTES effects
+        // starting at |effect| in turn.  They are counted in mixed samples and
+        // start on the exact sample they are due, however the updates fall.
+        // An interval of 0 stops the march, as does halting |effect|.
+        void set_march(Effect effect, uint16_t interval);
+
+        // Runs the mixer: applies queued commands and mixes the samples for
+        // the time since the last update.  Samples that don't fit in the
+        // buffer are dropped, so that sounds keep time with the game even if
+        // nothing reads the buffer.  After a long update, only the latest
+        // samples are mixed, and the sounds and the march skip ahead over the
+        // rest.
+        void update();
+        // Same as update(), but mixes the samples for |elapsed_time| ticks of
+        // game time instead, so that the march keeps time with the game.
+        void update(uint32_t elapsed_time);
+
+        // Waits for all sounds that are not looping to finish.  This runs the
+        // mixer, so it must be called from wherever update() is called.
+        void wait_for_all_to_finish();
+
+        // Copies up to |max_samples| mixed samples to |samples|.  Returns the
+        // number of samples copied.  For use by the audio output, which may
+        // call this from an interrupt handler.
+        uint16_t read_samples(int16_t* samples, uint16_t max_samples);
+
+    private:
+        enum CommandType {
+            COMMAND_PLAY,
+            COMMAND_PLAY_LOOP,
+            COMMAND_HALT,
+            COMMAND_HALT_ALL,
+            COMMAND_SET_MARCH,
+        };
+
+        struct Command {
+            uint8_t type;
+            uint8_t effect;
+            uint16_t value;     // Volume, or the interval of a march.
+        };
+
+        struct Voice {
+            const int8_t* data;     // NULL if the voice is not playing.
+            uint16_t length;
+            uint16_t position;
+            uint8_t effect;
+            uint8_t volume;
+            bool loop;
+        };
+
+        void push_command(uint8_t type, uint8_t effect, uint16_t value);
+        void run_command(const Command& command);
+        void start_voice(uint8_t effect, uint8_t volume, bool loop);
+        // Stops all the voices playing march notes.
+        void stop_march_notes();
+        // Mixes the next |count| samples into |samples|, starting march beats
+        // as they come due.  If |samples| is NULL, skips them instead.
+        void mix(int16_t* samples, uint16_t count);
+        // Mixes the next |count| samples of all voices into |samples|.
+        void mix_voices(int16_t* samples, uint8_t count);
+        // Moves all voices |count| samples ahead without mixing them.
+        void skip_voices(uint16_t count);
+        bool has_unlooped_voices() const;
+
+        const SoundClip* clips;
+        Voice voices[SOUND_NUM_VOICES];
+
+        // The first march note, the march interval, the number of samples
+        // until the next beat, and which note it plays.
+        uint8_t march_effect;
+        uint16_t march_interval;
+        uint16_t march_countdown;
+        uint8_t march_note;
+
+        // Written by the game, read by the mixer.
+        Command commands[SOUND_COMMAND_QUEUE_SIZE];
+        uint8_t command_head, command_tail;
+
+        // Written by the mixer, read by the audio output.
+        int16_t buffer[SOUND_BUFFER_SIZE];
+        uint8_t buffer_head, buffer_tail;
+
+        uint32_t last_update_time;
+        uint16_t sample_time_remainder;   // In units of 1/1000 samples.
     };
 
 }
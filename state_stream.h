@@ -0,0 +1,85 @@
+/*
+ state_stream.h
+ Classic Invaders
+
+ Copyright (c) 2013, Todd Steinackle, Simon Que
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the documentation and/or other
+ materials provided with the distribution.
+
+ * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)  nor the names of
+ its contributors may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef STATE_STREAM_H
+#define STATE_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SAVE_STATE_MAGIC        0x4943    // "CI"
+#define SAVE_STATE_VERSION           2
+
+// Callbacks for streaming a saved game state to and from storage.  |context| is
+// passed through unchanged.  A reader returns false if it could not provide
+// |size| bytes.
+typedef void (*StateWriter)(const void* data, uint16_t size, void* context);
+typedef bool (*StateReader)(void* data, uint16_t size, void* context);
+
+// Comes before the state data.  |size| is the number of bytes of state data
+// that follow.  The layout of the state data depends on the sizes of the game
+// structs, so a state can only be loaded by the same build that saved it.
+struct SaveStateHeader {
+    uint16_t magic;
+    uint16_t version;
+    uint16_t size;
+};
+
+// Moves blocks of state in one direction: out through a writer, in through a
+// reader, or nowhere, in which case it only counts bytes.  This way, a single
+// function describes the layout of the state for both saving and loading.
+class StateStream {
+  private:
+    StateWriter writer;
+    StateReader reader;
+    void* context;
+    uint16_t size;    // Number of bytes transferred so far.
+    bool ok;          // Cleared when the reader runs out of data.
+
+  public:
+    StateStream(StateWriter writer, StateReader reader, void* context) :
+        writer(writer), reader(reader), context(context), size(0), ok(true) {}
+
+    bool is_loading() const { return reader != NULL; }
+    bool is_ok() const { return ok; }
+    uint16_t get_size() const { return size; }
+
+    void transfer(void* data, uint16_t size) {
+        if (writer)
+            writer(data, size, context);
+        else if (reader && ok)
+            ok = reader(data, size, context);
+        this->size += size;
+    }
+};
+
+#endif  // STATE_STREAM_H
@@ -31,20 +31,134 @@
 */
 
 #include "status.h"
+
+#include <string.h>
+
+#include <avr/pgmspace.h>
+
 #include "screen.h"
+#include "ttf.h"
+
+// Layout, in text tiles.  The score and wave are on the top row, above the
+// bonus ship, and the lives are in the bottom left corner.
+#define SCORE_LABEL_X        0
+#define SCORE_X              6
+#define WAVE_LABEL_X        13
+#define WAVE_X              18
+#define TOP_ROW_Y            0
+#define LIVES_LABEL_X        0
+#define LIVES_X              6
+#define BOTTOM_ROW_Y        ((screen_h / SCREEN_TILE_SIZE) - 1)
 
-#define top_margin_y        10
-#define bottom_margin_y    575
-#define text_padding        15
-#define ship_padding         3
+namespace {
+
+    // For converting to decimal by subtraction, which is much cheaper than
+    // division on the AVR.  There must be one more entry than the most digits
+    // of any value.
+    const uint16_t kPowersOfTen[] PROGMEM = {
+        1, 10, 100, 1000,
+    };
+
+}  // namespace
 
 namespace Ui {
 
-    Status::Status()
+    Status::Status(TTFont* font) : font(font)
     {
+        reset();
     }
     Status::~Status()
     {
     }
 
+    void Status::reset()
+    {
+        memset(score_digits, 0, sizeof(score_digits));
+        memset(wave_digits, 0, sizeof(wave_digits));
+        memset(lives_digits, 0, sizeof(lives_digits));
+        dirty_score_digits = (1 << STATUS_SCORE_DIGITS) - 1;
+        dirty_wave_digits = (1 << STATUS_WAVE_DIGITS) - 1;
+        dirty_lives_digits = (1 << STATUS_LIVES_DIGITS) - 1;
+        labels_dirty = true;
+    }
+
+    void Status::set_score(const BCD& score)
+    {
+        // Show all nines if the score doesn't fit.
+        bool too_big = false;
+        for (uint8_t i = STATUS_SCORE_DIGITS; i < BCD_NUM_DIGITS; ++i)
+            too_big |= (score.get_digit(i) != 0);
+
+        for (uint8_t i = 0; i < STATUS_SCORE_DIGITS; ++i) {
+            uint8_t digit =
+                too_big ? 9 : score.get_digit(STATUS_SCORE_DIGITS - 1 - i);
+            if (score_digits[i] != digit) {
+                score_digits[i] = digit;
+                dirty_score_digits |= (1 << i);
+            }
+        }
+    }
+
+    void Status::set_wave(uint8_t wave)
+    {
+        set_value(wave_digits, STATUS_WAVE_DIGITS, wave, &dirty_wave_digits);
+    }
+
+    void Status::set_lives(uint8_t lives)
+    {
+        set_value(lives_digits, STATUS_LIVES_DIGITS, lives,
+                  &dirty_lives_digits);
+    }
+
+    void Status::draw()
+    {
+        if (labels_dirty) {
+            font->draw_text_P(SCORE_LABEL_X, TOP_ROW_Y, PSTR("SCORE"));
+            font->draw_text_P(WAVE_LABEL_X, TOP_ROW_Y, PSTR("WAVE"));
+            font->draw_text_P(LIVES_LABEL_X, BOTTOM_ROW_Y, PSTR("LIVES"));
+            labels_dirty = false;
+        }
+        draw_digits(SCORE_X, TOP_ROW_Y, score_digits, &dirty_score_digits);
+        draw_digits(WAVE_X, TOP_ROW_Y, wave_digits, &dirty_wave_digits);
+        draw_digits(LIVES_X, BOTTOM_ROW_Y, lives_digits, &dirty_lives_digits);
+    }
+
+    void Status::set_value(uint8_t* digits, uint8_t num_digits,
+                           uint16_t value, uint8_t* dirty_digits)
+    {
+        // Values that don't fit show as all nines.
+        if (value >= pgm_read_word(&kPowersOfTen[num_digits]))
+            value = pgm_read_word(&kPowersOfTen[num_digits]) - 1;
+        for (uint8_t i = 0; i < num_digits; ++i) {
+            uint16_t power_of_ten =
+                pgm_read_word(&kPowersOfTen[num_digits - 1 - i]);
+            uint8_t digit = 0;
+            while (value >= power_of_ten) {
+                value -= power_of_ten;
+                ++digit;
+            }
+            if (digits[i] != digit) {
+                digits[i] = digit;
+                *dirty_digits |= (1 << i);
+            }
+        }
+    }
+
+    void Status::draw_digits(uint8_t x, uint8_t y, const uint8_t* digits,
+                             uint8_t* dirty_digits)
+    {
+        if (!*dirty_digits)
+            return;
+        // Redraw everything from the first dirty digit to the last one in a
+        // single write.
+        uint8_t first = 0;
+        while (!(*dirty_digits & (1 << first)))
+            ++first;
+        uint8_t last = first;
+        while (*dirty_digits >> (last + 1))
+            ++last;
+        font->draw_digits(x + first, y, digits + first, last - first + 1);
+        *dirty_digits = 0;
+    }
+
 }
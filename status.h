@@ -33,12 +33,58 @@
 #ifndef STATUS_H
 #define STATUS_H
 
+#include <stdint.h>
+
+#include "bcd.h"
+
+// Number of digits shown for each value.  Larger values show as all nines.
+#define STATUS_SCORE_DIGITS     6
+#define STATUS_WAVE_DIGITS      2
+#define STATUS_LIVES_DIGITS     1
+
 namespace Ui {
 
+    class TTFont;
+
+    // Shows the score, wave and lives on the text layer.  It keeps the
+    // decimal digits of each value and only redraws the digits that changed,
+    // so updating the score costs a tilemap write or two.
     class Status {
+        TTFont* font;
+
+        // The digits of each value, most significant first.
+        uint8_t score_digits[STATUS_SCORE_DIGITS];
+        uint8_t wave_digits[STATUS_WAVE_DIGITS];
+        uint8_t lives_digits[STATUS_LIVES_DIGITS];
+
+        // Bit i is set if digit i of the corresponding value has to be
+        // redrawn.
+        uint8_t dirty_score_digits;
+        uint8_t dirty_wave_digits;
+        uint8_t dirty_lives_digits;
+        bool labels_dirty;
+
+        // Stores |value| in |digits| and marks the digits that changed.
+        void set_value(uint8_t* digits, uint8_t num_digits, uint16_t value,
+                       uint8_t* dirty_digits);
+        // Redraws the dirty digits in |digits| starting at column |x|.
+        void draw_digits(uint8_t x, uint8_t y, const uint8_t* digits,
+                         uint8_t* dirty_digits);
     public:
-        Status();
+        Status(TTFont* font);
         ~Status();
+
+        // Sets all values to 0 and queues the whole display to be redrawn,
+        // e.g. after the text layer has been cleared.
+        void reset();
+
+        // The score is already in decimal, so this only compares digits.
+        void set_score(const BCD& score);
+        void set_wave(uint8_t wave);
+        void set_lives(uint8_t lives);
+
+        // Redraws whatever changed.
+        void draw();
     };
 
 }
@@ -38,6 +38,98 @@
 
 #include <Arduino.h>
 #include <DuinoCube.h>
+#ifdef __AVR__
+#include <avr/sleep.h>
+#endif
+
+// Stack painting.
+#define STACK_PAINT_VALUE       0xc5
+// Leave this much room below the stack pointer when painting, for the
+// painting function's own use.
+#define STACK_PAINT_MARGIN        16
+
+#ifdef __AVR__
+extern uint8_t __bss_end;
+extern uint8_t* __brkval;     // Top of the heap, if anything used malloc().
+#endif
+
+namespace {
+
+#ifdef __AVR__
+    // Returns the lowest address the stack can grow into.  The game doesn't
+    // use the heap, but libraries might.
+    uint8_t* get_stack_limit() {
+        return __brkval ? __brkval : &__bss_end;
+    }
+#endif
+
+    // Key events written by poll_keys(), read by get_key_event().  These and
+    // |polled_keys| are only used from the main loop, never from an interrupt
+    // handler, so they need no locking.
+    System::KeyEvent key_events[KEY_EVENT_QUEUE_SIZE];
+    uint8_t key_event_head, key_event_tail;
+
+    uint8_t polled_keys;          // Key state as of the last poll.
+    uint32_t last_key_poll_time;
+
+    uint8_t get_key_mask(const System::KeyState& key_state) {
+        uint8_t mask = 0;
+        if (key_state.fire)
+            mask |= (1 << System::KEY_FIRE);
+        if (key_state.pause)
+            mask |= (1 << System::KEY_PAUSE);
+        if (key_state.quit)
+            mask |= (1 << System::KEY_QUIT);
+        if (key_state.left)
+            mask |= (1 << System::KEY_LEFT);
+        if (key_state.right)
+            mask |= (1 << System::KEY_RIGHT);
+        return mask;
+    }
+
+}  // namespace
+
+#ifdef SIMULATION_RUNNER
+namespace {
+
+    uint32_t sim_ticks;          // Simulated system timer.
+
+    // State of the scripted player.
+    uint32_t bot_random_state;   // Linear congruential generator state.
+    uint32_t bot_turn_time;      // When to pick a new direction.
+    bool bot_moving_right;
+    bool bot_fire;
+
+    // Returns 15 pseudo-random bits.
+    uint16_t bot_rand() {
+        bot_random_state = bot_random_state * 1103515245 + 12345;
+        return (bot_random_state >> 16) & 0x7fff;
+    }
+
+    // Moves back and forth at random intervals and fires as often as
+    // possible.
+    System::KeyState get_bot_key_state() {
+        System::KeyState key_state;
+        memset(&key_state, 0, sizeof(key_state));
+
+        if (sim_ticks >= bot_turn_time) {
+            bot_moving_right = bot_rand() & 1;
+            bot_turn_time = sim_ticks + 200 + bot_rand() % 1500;
+        }
+        if (bot_moving_right)
+            key_state.right = 1;
+        else
+            key_state.left = 1;
+
+        // The fire button has to be released between shots.
+        bot_fire = !bot_fire;
+        key_state.fire = bot_fire;
+
+        return key_state;
+    }
+
+}  // namespace
+#endif  // defined(SIMULATION_RUNNER)
 
 namespace System {
 
@@ -46,6 +138,9 @@ namespace System {
     }
 
     KeyState get_key_state() {
+#ifdef SIMULATION_RUNNER
+        return get_bot_key_state();
+#else
         KeyState key_state;
         memset(&key_state, 0, sizeof(key_state));
 
@@ -62,16 +157,125 @@ namespace System {
             key_state.fire = 1;
 
         return key_state;
+#endif
+    }
+
+    void poll_keys() {
+        uint32_t now = get_ticks();
+        if (now == last_key_poll_time)
+            return;
+        last_key_poll_time = now;
+
+        uint8_t keys = get_key_mask(get_key_state());
+        uint8_t changed_keys = keys ^ polled_keys;
+        for (uint8_t key = 0; changed_keys; ++key, changed_keys >>= 1) {
+            if (!(changed_keys & 1))
+                continue;
+            // If the queue is full, leave the key's polled state alone, so the
+            // change is picked up again by a later poll.
+            uint8_t head = key_event_head;
+            if ((uint8_t)(head - key_event_tail) >=
+                    KEY_EVENT_QUEUE_SIZE) {
+                break;
+            }
+            KeyEvent& event = key_events[head % KEY_EVENT_QUEUE_SIZE];
+            event.time = now;
+            event.key = key;
+            event.pressed = keys & (1 << key);
+            key_event_head = head + 1;
+            polled_keys ^= (1 << key);
+        }
+    }
+
+    bool get_key_event(KeyEvent* event) {
+        uint8_t tail = key_event_tail;
+        if (tail == key_event_head)
+            return false;
+        *event = key_events[tail % KEY_EVENT_QUEUE_SIZE];
+        key_event_tail = tail + 1;
+        return true;
+    }
+
+    void clear_key_events() {
+        key_event_tail = key_event_head;
+        polled_keys = get_key_mask(get_key_state());
+        last_key_poll_time = get_ticks();
+    }
+
+    uint8_t get_polled_keys() {
+        return polled_keys;
     }
 
     // This is just a wrapper around SDL_GetTicks.  As part of the embedded port,
     // its contents will eventually be replaced with something else.
     uint32_t get_ticks() {
+#ifdef SIMULATION_RUNNER
+        return sim_ticks;
+#else
         return millis();
+#endif
     }
 
     void delay(uint16_t num_ticks) {
+#ifdef SIMULATION_RUNNER
+        advance_ticks(num_ticks);
+#else
+        // The tick counter can skip a value, so don't wait for it to equal
+        // |final_time|.
         uint32_t final_time = get_ticks() + num_ticks;
-        while (get_ticks() != final_time);
+        while ((int32_t)(get_ticks() - final_time) < 0) {
+            poll_keys();
+            sleep();
+        }
+#endif
+    }
+
+    void sleep() {
+#ifdef __AVR__
+        // Idle mode keeps the timers running, so the tick interrupt wakes the
+        // CPU.
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_mode();
+#endif
+    }
+
+    uint32_t get_real_ticks() {
+        return millis();
+    }
+
+    // The stack only runs into static data on the board.  There is nothing
+    // to measure on other builds.
+    void paint_stack() {
+#ifdef __AVR__
+        uint8_t* end = (uint8_t*)SP - STACK_PAINT_MARGIN;
+        for (uint8_t* ptr = get_stack_limit(); ptr < end; ++ptr)
+            *ptr = STACK_PAINT_VALUE;
+#endif
+    }
+
+    uint16_t get_min_free_stack() {
+#ifdef __AVR__
+        const uint8_t* limit = get_stack_limit();
+        const uint8_t* ptr = limit;
+        while (ptr < (const uint8_t*)SP && *ptr == STACK_PAINT_VALUE)
+            ++ptr;
+        return ptr - limit;
+#else
+        return 0;
+#endif
+    }
+
+#ifdef SIMULATION_RUNNER
+    void init_simulation(uint32_t seed) {
+        sim_ticks = 0;
+        bot_random_state = seed;
+        bot_turn_time = 0;
+        bot_moving_right = false;
+        bot_fire = false;
+    }
+
+    void advance_ticks(uint16_t num_ticks) {
+        sim_ticks += num_ticks;
     }
+#endif
 }
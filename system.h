@@ -35,6 +35,21 @@
 
 #include <stdint.h>
 
+// Define this to play a batch of seeded games with a scripted player instead of
+// reading the gamepad.  Time is simulated, so the games do not wait for the
+// display and run as fast as the game logic allows.
+//#define SIMULATION_RUNNER
+
+// The games are played one after another on the board, since the entities keep
+// static pointers to the game and screen.  A seeded game is about 1250 frames
+// and each frame still drives the video hardware, so keep this small enough to
+// finish in a few minutes.
+#define NUM_SIMULATED_GAMES           32
+
+// Number of key events that can be queued between game loops.  Must be a power
+// of two, no larger than 128.
+#define KEY_EVENT_QUEUE_SIZE          16
+
 namespace System {
 
     // Bitfield struct containing state of all the relevant keys.  Each key bit
@@ -47,17 +62,71 @@ namespace System {
         int right  :1;
     };
 
+    // Keys, as reported in KeyEvents.
+    enum Key { KEY_FIRE, KEY_PAUSE, KEY_QUIT, KEY_LEFT, KEY_RIGHT, NUM_KEYS };
+
+    // A key being pressed or released, and when.
+    struct KeyEvent {
+        uint32_t time;
+        uint8_t key;
+        bool pressed;
+    };
+
     // Initializes system resources.
     bool init();
 
     // Returns the current key state.
     KeyState get_key_state();
 
+    // Reads the keys and queues an event for each key that changed since the
+    // last read.  Reads at most once per tick, so it can be called from wait
+    // loops.  Calling it while waiting catches presses shorter than a frame
+    // and timestamps them when they happen, not when the game gets to them.
+    void poll_keys();
+
+    // Removes the oldest queued key event and copies it to |event|.  Returns
+    // false if there are none.
+    bool get_key_event(KeyEvent* event);
+
+    // Drops all queued key events and takes the current key state as the
+    // starting point for new ones.
+    void clear_key_events();
+
+    // Returns the state of the keys as of the last poll_keys(), with bit N set
+    // if Key N is down.
+    uint8_t get_polled_keys();
+
     // Returns the number of ticks on a system timer.
     uint32_t get_ticks();
 
     // Waits for number of ticks.
     void delay(uint16_t num_ticks);
+
+    // Stops the CPU until the next interrupt, which is at most a tick away.
+    // Does nothing where there is no way to do that.
+    void sleep();
+
+    // Returns the number of ticks on the real system timer, even when time is
+    // being simulated.
+    uint32_t get_real_ticks();
+
+    // Fills the unused part of the stack with a known pattern.  Everything
+    // between the end of static data (or the heap) and the current stack
+    // pointer is unused.
+    void paint_stack();
+
+    // Returns the number of stack bytes that have not been touched since the
+    // last paint_stack(), i.e. how close the stack has come to static data.
+    uint16_t get_min_free_stack();
+
+#ifdef SIMULATION_RUNNER
+    // Resets the simulated clock and the scripted player.  The scripted player
+    // uses its own random number generator, seeded with |seed|.
+    void init_simulation(uint32_t seed);
+
+    // Advances the simulated clock.
+    void advance_ticks(uint16_t num_ticks);
+#endif
 }
 
 
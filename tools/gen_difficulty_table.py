@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+#
+# gen_difficulty_table.py
+# Classic Invaders
+#
+# Copyright (c) 2013, Todd Steinackle, Simon Que
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)
+#   nor the names of its contributors may be used to endorse or promote products
+#   derived from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Generates difficulty_table.h, the per-wave difficulty parameters and alien
+# speeds.  The whole difficulty curve is defined here.  To change it, edit the
+# values below and run:
+#   tools/gen_difficulty_table.py > difficulty_table.h
+
+import sys
+
+# Number of waves in the table.  Later waves use the last entry.
+NUM_WAVES = 16
+
+NUM_ALIENS = 60
+
+# Fixed point formats, see fixed_point.h.
+FIXED_POINT_SHIFT = 4
+FIXED_POINT_SHIFT_32 = 8
+
+# Alien speeds, in pixels per second.
+ALIEN_WAVE_START_SPEED = 64
+ALIEN_WAVE_SPEED_INCREASE = 2        # Per wave, up to wave 6.
+ALIEN_HIGH_WAVE_SPEED_INCREASE = 1   # Per wave, after wave 6.
+
+# Speed multipliers applied when an alien is killed.
+ALIEN_SPEED_BOOST = 1.027
+ALIEN_SPEED_BOOST_EXTRA = 1.15       # Also applied when few aliens are left.
+EXTRA_BOOST_ALIEN_COUNTS = (4, 2, 1)
+
+MAX_NUM_ALIEN_SHOTS = 32
+
+# Indexed by min(wave, 6), where wave starts from 0.
+ALIEN_ODD_RANGE_VALUES = (10, 9, 8, 8, 7, 6, 6)
+BONUS_SELECT_MAX = (5, 5, 4, 4, 3, 2, 2)
+LAUNCH_DELAY_MAX = (4, 4, 3, 3, 3, 3, 2)
+
+
+def to_fixed32(value):
+    return int(value * (1 << FIXED_POINT_SHIFT_32))
+
+
+def increase_speed(speed, increase):
+    """Speeds up |speed| by the fixed32 factor |increase|.
+
+    If the increase is too small to change the speed, it goes up by one
+    instead.
+    """
+    new_speed = (speed * increase) >> FIXED_POINT_SHIFT_32
+    if new_speed != speed or speed == 0:
+        return new_speed
+    return speed + 1
+
+
+def wave_parameters():
+    """Yields the parameters of each wave."""
+    shot_delay = 0
+    num_shots = 0
+    for wave in range(NUM_WAVES):
+        if wave < 6:
+            shot_delay = 400 - wave * 25
+            num_shots = 16 + wave
+            speed = ALIEN_WAVE_START_SPEED + wave * ALIEN_WAVE_SPEED_INCREASE
+        else:
+            if shot_delay > 200:
+                shot_delay -= 20
+                num_shots = min(num_shots + 3, MAX_NUM_ALIEN_SHOTS)
+            speed = (ALIEN_WAVE_START_SPEED + 5 * ALIEN_WAVE_SPEED_INCREASE +
+                     (wave - 5) * ALIEN_HIGH_WAVE_SPEED_INCREASE)
+        select = min(wave, 6)
+        yield (shot_delay, num_shots, ALIEN_ODD_RANGE_VALUES[select],
+               BONUS_SELECT_MAX[select], LAUNCH_DELAY_MAX[select],
+               speed << FIXED_POINT_SHIFT)
+
+
+def alien_speeds(start_speed):
+    """Returns the alien speed for each number of remaining aliens."""
+    speeds = [0] * (NUM_ALIENS + 1)
+    speed = start_speed
+    speeds[NUM_ALIENS] = speed
+    for alien_count in range(NUM_ALIENS - 1, 0, -1):
+        speed = increase_speed(speed, to_fixed32(ALIEN_SPEED_BOOST))
+        if alien_count in EXTRA_BOOST_ALIEN_COUNTS:
+            speed = increase_speed(speed, to_fixed32(ALIEN_SPEED_BOOST_EXTRA))
+        assert speed < (1 << 15)
+        speeds[alien_count] = speed
+    return speeds
+
+
+def main():
+    waves = list(wave_parameters())
+    out = sys.stdout
+    out.write('// Generated by tools/gen_difficulty_table.py.  Do not edit.\n')
+    out.write('\n')
+    out.write('#ifndef DIFFICULTY_TABLE_H\n')
+    out.write('#define DIFFICULTY_TABLE_H\n')
+    out.write('\n')
+    out.write('#include <stdint.h>\n')
+    out.write('\n')
+    out.write('#include <avr/pgmspace.h>\n')
+    out.write('\n')
+    out.write('#define NUM_DIFFICULTY_WAVES           %d\n' % NUM_WAVES)
+    out.write('#define DIFFICULTY_TABLE_NUM_ALIENS    %d\n' % NUM_ALIENS)
+    out.write('\n')
+    out.write('struct WaveDifficulty {\n')
+    out.write('    uint16_t alien_shot_delay;\n')
+    out.write('    uint8_t num_alien_shots;\n')
+    out.write('    uint8_t alien_odd_range;\n')
+    out.write('    uint8_t bonus_select_max;\n')
+    out.write('    uint8_t launch_delay_max;\n')
+    out.write('};\n')
+    out.write('\n')
+    out.write('const WaveDifficulty kWaveDifficulty[NUM_DIFFICULTY_WAVES] '
+              'PROGMEM = {\n')
+    for wave in waves:
+        out.write('    { %d, %d, %d, %d, %d },\n' % wave[:5])
+    out.write('};\n')
+    out.write('\n')
+    out.write('// Alien speed in fixed point, indexed by wave and the number '
+              'of aliens left.\n')
+    out.write('const int16_t kAlienSpeeds[NUM_DIFFICULTY_WAVES]'
+              '[DIFFICULTY_TABLE_NUM_ALIENS + 1] PROGMEM = {\n')
+    for wave in waves:
+        speeds = alien_speeds(wave[5])
+        out.write('    {\n')
+        for i in range(0, len(speeds), 10):
+            out.write('        ' +
+                      ' '.join('%d,' % s for s in speeds[i:i + 10]) + '\n')
+        out.write('    },\n')
+    out.write('};\n')
+    out.write('\n')
+    out.write('#endif  // DIFFICULTY_TABLE_H\n')
+
+
+if __name__ == '__main__':
+    main()
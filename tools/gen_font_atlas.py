@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+#
+# gen_font_atlas.py
+# Classic Invaders
+#
+# Copyright (c) 2013, Todd Steinackle, Simon Que
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)
+#   nor the names of its contributors may be used to endorse or promote products
+#   derived from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Rasterizes the glyphs used by the game into a tile atlas, so the board only
+# has to copy tilemap entries to draw text.  Each glyph is one 16x16 tile of
+# 8-bit pixels.  A pixel's value is its coverage, from 0 (transparent) to
+# NUM_SHADES - 1, and TTFont::init() sets up a palette ramp to match.
+#
+# To regenerate the atlas and the glyph table:
+#   tools/gen_font_atlas.py --font data/LiberationMono-Regular.ttf --size 14 \
+#       --atlas data/font.raw
+#   tools/gen_font_atlas.py --header > font_atlas.h
+#
+# Rasterizing needs the Python Imaging Library (PIL).  The header does not.
+
+import argparse
+import sys
+
+# Must match SCREEN_TILE_SIZE.
+TILE_SIZE = 16
+
+NUM_SHADES = 16
+
+# The glyphs in the atlas, in tile order.  Tile 0 is blank, and is also used
+# for characters that are not here.  Lowercase letters use the uppercase
+# glyphs.  The digits must stay in order, for TTFont::draw_digits().
+GLYPHS = ' 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ!-.:/'
+
+FIRST_CHAR = ' '
+LAST_CHAR = '~'
+
+
+def get_tile(char):
+    return max(GLYPHS.find(char.upper()), 0)
+
+
+def write_header(out):
+    out.write('// Generated by tools/gen_font_atlas.py.  Do not edit.\n')
+    out.write('\n')
+    out.write('#ifndef FONT_ATLAS_H\n')
+    out.write('#define FONT_ATLAS_H\n')
+    out.write('\n')
+    out.write('#include <stdint.h>\n')
+    out.write('\n')
+    out.write('#include <avr/pgmspace.h>\n')
+    out.write('\n')
+    out.write('#define FONT_NUM_TILES             %d\n' % len(GLYPHS))
+    out.write('#define FONT_NUM_SHADES            %d\n' % NUM_SHADES)
+    out.write('#define FONT_FIRST_CHAR          \'%s\'\n' % FIRST_CHAR)
+    out.write('#define FONT_LAST_CHAR           \'%s\'\n' % LAST_CHAR)
+    out.write('\n')
+    out.write('// Atlas tile of each character from FONT_FIRST_CHAR to '
+              'FONT_LAST_CHAR.\n')
+    chars = [chr(c) for c in range(ord(FIRST_CHAR), ord(LAST_CHAR) + 1)]
+    out.write('const uint8_t kFontGlyphTiles[] PROGMEM = {\n')
+    for i in range(0, len(chars), 16):
+        out.write('    ' +
+                  ' '.join('%d,' % get_tile(c) for c in chars[i:i + 16]) +
+                  '\n')
+    out.write('};\n')
+    out.write('\n')
+    out.write('#endif  // FONT_ATLAS_H\n')
+
+
+def write_atlas(filename, font_filename, size):
+    from PIL import Image, ImageDraw, ImageFont
+
+    if size > TILE_SIZE:
+        sys.exit('Glyphs must fit in a %d-pixel tile' % TILE_SIZE)
+    font = ImageFont.truetype(font_filename, size)
+    ascent, descent = font.getmetrics()
+    # Center the line of text vertically in the tile.
+    top = (TILE_SIZE - (ascent + descent)) // 2
+
+    atlas = bytearray()
+    for char in GLYPHS:
+        tile = Image.new('L', (TILE_SIZE, TILE_SIZE), 0)
+        if char != ' ':
+            left, _, right, _ = font.getbbox(char)
+            x = (TILE_SIZE - (right - left)) // 2 - left
+            ImageDraw.Draw(tile).text((x, top), char, fill=255, font=font)
+        atlas.extend(value * NUM_SHADES // 256 for value in tile.tobytes())
+    with open(filename, 'wb') as out:
+        out.write(atlas)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Rasterizes the game font into a tile atlas.')
+    parser.add_argument('--font', help='TrueType font file')
+    parser.add_argument('--size', type=int, default=14,
+                        help='Font size in pixels')
+    parser.add_argument('--atlas', help='Write the atlas tiles to this file')
+    parser.add_argument('--header', action='store_true',
+                        help='Print the glyph table header')
+    args = parser.parse_args()
+
+    if args.atlas:
+        if not args.font:
+            parser.error('--atlas needs --font')
+        write_atlas(args.atlas, args.font, args.size)
+    if args.header:
+        write_header(sys.stdout)
+    if not args.atlas and not args.header:
+        parser.error('Nothing to write, use --atlas and/or --header')
+
+
+if __name__ == '__main__':
+    main()
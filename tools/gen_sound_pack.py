@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+#
+# gen_sound_pack.py
+# Classic Invaders
+#
+# Copyright (c) 2013, Todd Steinackle, Simon Que
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# * Neither the name of The No Quarter Arcade (http://www.noquarterarcade.com/)
+#   nor the names of its contributors may be used to endorse or promote products
+#   derived from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Decodes the .ogg sound effects in data/ into signed 8-bit mono PCM at the
+# mixer's sample rate, so that nothing has to be decoded while the game runs.
+# The clips are written to a header as PROGMEM arrays:
+#
+#   tools/gen_sound_pack.py --header sound_data.h
+#
+# Build with SOUND_DATA defined in sound.h to use it.  Decoding uses whichever
+# of oggdec, sox or ffmpeg is installed.
+#
+# Only the effects that the game plays are packed.  The notes of the background
+# march are synthesized instead.
+#
+# The clips are read with memcpy_P() through 16-bit pointers, so they have to be
+# in the low 64 KB of flash, along with the sketch's other PROGMEM data.  The
+# pack is limited to MAX_PACK_BYTES, and --max-bytes sets a lower budget.
+
+import argparse
+import array
+import io
+import math
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import wave
+
+# Must match sound.h.
+SAMPLE_RATE = 8000
+
+# Sound effect file names, in the order of Sound::Effect.
+EFFECTS = (
+    'shot', 'explosion', 'alien_death', 'free_guy', 'game_over', 'start_wave',
+    'big_bonus', 'small_bonus', 'shot_collision', 'active_bonus',
+    'start_screen', 'player_dead', 'player_rebirth', 'aliens_landed',
+    'end_wave', 'menu_select', 'zap_scores', 'new_high_score', 'about_screen',
+    'wrong_key', 'help_screen', 'exit', 'bg', 'bg_4', 'bg_3', 'bg_2', 'bg_1',
+    'march_1', 'march_2', 'march_3', 'march_4',
+)
+
+# The effects that the game plays.  The rest are for the menus and screens of
+# the original game, which this port doesn't have.  The background music loops
+# are also left out, since they are 8 to 16 seconds long, far too big for
+# program memory.  The game plays the march notes instead.
+USED_EFFECTS = (
+    'shot', 'explosion', 'alien_death', 'free_guy', 'game_over', 'start_wave',
+    'big_bonus', 'small_bonus', 'shot_collision', 'active_bonus',
+    'player_dead', 'player_rebirth', 'aliens_landed', 'end_wave',
+    'march_1', 'march_2', 'march_3', 'march_4',
+)
+
+# Like the arcade game's, the march is four descending bass notes, one per
+# alien step.  Each is a square wave that dies away before the next step can
+# come, at MARCH_MIN_INTERVAL in game_defs.h.
+MARCH_FREQUENCIES = {
+    'march_1': 98.0,
+    'march_2': 87.3,
+    'march_3': 82.4,
+    'march_4': 73.4,
+}
+MARCH_NOTE_SECONDS = 0.09
+MARCH_NOTE_DECAY = 30.0     # Per second.
+MARCH_NOTE_VOLUME = 0.8
+
+# SoundClip::length is 16 bits.
+MAX_CLIP_LENGTH = 0xffff
+
+# Leaves 8 KB of the low 64 KB of flash for the interrupt vectors, the
+# difficulty tables, the printf_P() strings and the other PROGMEM data.
+MAX_PACK_BYTES = 56 * 1024
+
+
+def decode_to_wav(filename):
+    """Returns the contents of |filename| decoded into a WAV file."""
+    if shutil.which('oggdec'):
+        command = ['oggdec', '-Q', '-o', '-', filename]
+    elif shutil.which('sox'):
+        command = ['sox', filename, '-t', 'wav', '-']
+    elif shutil.which('ffmpeg'):
+        command = ['ffmpeg', '-loglevel', 'error', '-i', filename,
+                   '-f', 'wav', '-']
+    else:
+        sys.exit('Need one of oggdec, sox or ffmpeg to decode %s' % filename)
+    return subprocess.run(command, stdout=subprocess.PIPE, check=True).stdout
+
+
+def read_wav(data):
+    """Returns the samples of a 16-bit WAV file, mixed down to mono and
+    scaled to [-1, 1], and the sample rate."""
+    with wave.open(io.BytesIO(data)) as wav:
+        if wav.getsampwidth() != 2:
+            sys.exit('Expected 16-bit samples')
+        channels = wav.getnchannels()
+        rate = wav.getframerate()
+        samples = array.array('h', wav.readframes(wav.getnframes()))
+    if sys.byteorder == 'big':
+        samples.byteswap()
+    mono = [sum(samples[i:i + channels]) / (channels * 32768.0)
+            for i in range(0, len(samples), channels)]
+    return mono, rate
+
+
+def resample(samples, rate, new_rate):
+    """Linear interpolation is good enough for 8 kHz sound effects."""
+    if rate == new_rate or not samples:
+        return samples
+    length = int(len(samples) * new_rate / rate)
+    result = []
+    for i in range(length):
+        position = i * rate / new_rate
+        index = int(position)
+        fraction = position - index
+        next_index = min(index + 1, len(samples) - 1)
+        result.append(samples[index] * (1 - fraction) +
+                      samples[next_index] * fraction)
+    return result
+
+
+def to_int8(samples):
+    return bytes(max(-128, min(127, int(round(s * 127)))) & 0xff
+                 for s in samples)
+
+
+def synthesize_march_note(frequency):
+    samples = []
+    for i in range(int(MARCH_NOTE_SECONDS * SAMPLE_RATE)):
+        time = i / SAMPLE_RATE
+        square = 1.0 if (time * frequency) % 1.0 < 0.5 else -1.0
+        samples.append(MARCH_NOTE_VOLUME * square *
+                       math.exp(-time * MARCH_NOTE_DECAY))
+    return samples
+
+
+def load_clips(data_dir, max_seconds):
+    clips = []
+    max_length = min(int(max_seconds * SAMPLE_RATE), MAX_CLIP_LENGTH)
+    for name in EFFECTS:
+        if name not in USED_EFFECTS:
+            clips.append(b'')
+            continue
+        if name in MARCH_FREQUENCIES:
+            clips.append(to_int8(
+                synthesize_march_note(MARCH_FREQUENCIES[name])))
+            continue
+        filename = os.path.join(data_dir, name + '.ogg')
+        if not os.path.exists(filename):
+            print('Missing %s, leaving it silent' % filename, file=sys.stderr)
+            clips.append(b'')
+            continue
+        samples, rate = read_wav(decode_to_wav(filename))
+        samples = resample(samples, rate, SAMPLE_RATE)[:max_length]
+        clips.append(to_int8(samples))
+    return clips
+
+
+def write_header(filename, clips):
+    with open(filename, 'w') as out:
+        out.write('// Generated by tools/gen_sound_pack.py.  Do not edit.\n')
+        out.write('\n')
+        out.write('#ifndef SOUND_DATA_H\n')
+        out.write('#define SOUND_DATA_H\n')
+        out.write('\n')
+        out.write('#include <avr/pgmspace.h>\n')
+        out.write('\n')
+        out.write('#include "sound.h"\n')
+        out.write('\n')
+        for name, clip in zip(EFFECTS, clips):
+            if not clip:
+                continue
+            out.write('const int8_t kSoundData_%s[] PROGMEM = {\n' % name)
+            signed = struct.unpack('%db' % len(clip), clip)
+            for i in range(0, len(signed), 16):
+                out.write('    ' +
+                          ' '.join('%d,' % s for s in signed[i:i + 16]) + '\n')
+            out.write('};\n')
+            out.write('\n')
+        out.write('const Sound::SoundClip kSoundClips[Sound::NUM_SOUND_EFFECTS] '
+                  'PROGMEM = {\n')
+        for name, clip in zip(EFFECTS, clips):
+            if clip:
+                out.write('    { kSoundData_%s, %d },\n' % (name, len(clip)))
+            else:
+                out.write('    { NULL, 0 },  // %s\n' % name)
+        out.write('};\n')
+        out.write('\n')
+        out.write('#endif  // SOUND_DATA_H\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Decodes the .ogg sound effects into PCM clips.')
+    parser.add_argument('--data-dir', default='data')
+    parser.add_argument('--header', required=True,
+                        help='Write a PROGMEM header')
+    parser.add_argument('--max-seconds', type=float, default=0.5,
+                        help='Truncate each clip to this length')
+    parser.add_argument('--max-bytes', type=int, default=MAX_PACK_BYTES,
+                        help='Fail if the clips add up to more than this, '
+                             'at most %d' % MAX_PACK_BYTES)
+    args = parser.parse_args()
+    if args.max_bytes > MAX_PACK_BYTES:
+        parser.error('--max-bytes can be at most %d' % MAX_PACK_BYTES)
+
+    clips = load_clips(args.data_dir, args.max_seconds)
+    total_size = sum(len(clip) for clip in clips)
+    print('%d bytes of sound data' % total_size, file=sys.stderr)
+    if total_size > args.max_bytes:
+        sys.exit('Sound data is over the budget of %d bytes, '
+                 'lower --max-seconds' % args.max_bytes)
+
+    write_header(args.header, clips)
+
+
+if __name__ == '__main__':
+    main()
@@ -32,15 +32,95 @@
 
 #include "ttf.h"
 
+#include <string.h>
+
+#include <avr/pgmspace.h>
+
+#include "font_atlas.h"
+#include "screen.h"
+
 #define NDEBUG
 
+#define TILEMAP_WIDTH     32
+#define TILEMAP_HEIGHT    32
+
 namespace Ui {
 
-    TTFont::TTFont(const char* ttf_name, int size)
+    TTFont::TTFont(Graphics::Screen* screen, uint8_t layer) :
+        screen(screen),
+        layer(layer)
     {
     }
     TTFont::~TTFont()
     {
     }
 
+    void TTFont::init(uint8_t palette, uint16_t vram_offset)
+    {
+        // Without the atlas, the layer would show whatever else is in VRAM.
+        if (vram_offset == FONT_NOT_LOADED) {
+            screen->setup_tile_layer(layer, false, palette, 0, 0);
+            return;
+        }
+        // The atlas pixels are glyph coverage values.  Shade them from black
+        // to white, with 0 as the transparent color.
+        for (uint8_t shade = 1; shade < FONT_NUM_SHADES; ++shade) {
+            uint8_t value = shade * 255 / (FONT_NUM_SHADES - 1);
+            screen->set_palette_entry(palette, shade, value, value, value);
+        }
+        screen->setup_tile_layer(layer, true, palette, vram_offset, 0);
+        screen->scroll_tile_layer(layer, 0, 0);
+        for (uint8_t y = 0; y < TILEMAP_HEIGHT; ++y)
+            clear_text(0, y, TILEMAP_WIDTH);
+    }
+
+    void TTFont::draw_text(uint8_t x, uint8_t y, const char* text,
+                           bool in_progmem)
+    {
+        uint16_t tiles[TILEMAP_WIDTH];
+        uint8_t length = 0;
+        while (x + length < TILEMAP_WIDTH) {
+            char c = in_progmem ? pgm_read_byte(text + length) : text[length];
+            if (c == '\0')
+                break;
+            if (c >= FONT_FIRST_CHAR && c <= FONT_LAST_CHAR)
+                tiles[length] = pgm_read_byte(
+                        &kFontGlyphTiles[c - FONT_FIRST_CHAR]);
+            else
+                tiles[length] = 0;
+            ++length;
+        }
+        if (length > 0)
+            screen->set_tilemap_data(layer, x, y, tiles,
+                                     length * sizeof(tiles[0]));
+    }
+
+    void TTFont::draw_digits(uint8_t x, uint8_t y, const uint8_t* digits,
+                             uint8_t count)
+    {
+        // The digit glyphs are in order in the atlas.
+        uint16_t zero_tile =
+            pgm_read_byte(&kFontGlyphTiles['0' - FONT_FIRST_CHAR]);
+        uint16_t tiles[TILEMAP_WIDTH];
+        if (x >= TILEMAP_WIDTH)
+            return;
+        if (count > TILEMAP_WIDTH - x)
+            count = TILEMAP_WIDTH - x;
+        for (uint8_t i = 0; i < count; ++i)
+            tiles[i] = zero_tile + digits[i];
+        screen->set_tilemap_data(layer, x, y, tiles, count * sizeof(tiles[0]));
+    }
+
+    void TTFont::clear_text(uint8_t x, uint8_t y, uint8_t length)
+    {
+        uint16_t tiles[TILEMAP_WIDTH];
+        if (x >= TILEMAP_WIDTH || length == 0)
+            return;
+        if (length > TILEMAP_WIDTH - x)
+            length = TILEMAP_WIDTH - x;
+        memset(tiles, 0, length * sizeof(tiles[0]));
+        screen->set_tilemap_data(layer, x, y, tiles,
+                                 length * sizeof(tiles[0]));
+    }
+
 }
@@ -33,12 +33,50 @@
 #ifndef TTF_H
 #define TTF_H
 
+#include <stdint.h>
+
+// VRAM offset passed to TTFont::init() when the atlas could not be loaded.
+#define FONT_NOT_LOADED               0xffff
+
+namespace Graphics {
+    class Screen;
+}
+
 namespace Ui {
 
+    // Draws text on a tile layer, one character per tile.  The glyphs are
+    // rasterized ahead of time into a tile atlas by tools/gen_font_atlas.py
+    // and loaded into VRAM with the other images, so drawing a string only
+    // takes one tilemap write.
     class TTFont {
+        Graphics::Screen* screen;
+        uint8_t layer;
+
+        void draw_text(uint8_t x, uint8_t y, const char* text,
+                       bool in_progmem);
     public:
-        TTFont(const char* ttf_name, int size);
+        TTFont(Graphics::Screen* screen, uint8_t layer);
         ~TTFont();
+
+        // Shows the atlas at |vram_offset| on the tile layer, sets up
+        // |palette| for it, and clears the layer.  If |vram_offset| is
+        // FONT_NOT_LOADED, the layer is turned off instead.
+        void init(uint8_t palette, uint16_t vram_offset);
+
+        // Draws |text| starting at tile column |x| and row |y|.  Whatever
+        // goes past the edge of the tilemap is cut off.
+        void draw_text(uint8_t x, uint8_t y, const char* text) {
+            draw_text(x, y, text, false);
+        }
+        // Same as draw_text(), for |text| in program memory.
+        void draw_text_P(uint8_t x, uint8_t y, const char* text) {
+            draw_text(x, y, text, true);
+        }
+        // Draws |count| decimal digits, each from 0 to 9.
+        void draw_digits(uint8_t x, uint8_t y, const uint8_t* digits,
+                         uint8_t count);
+        // Blanks |length| characters starting at column |x| and row |y|.
+        void clear_text(uint8_t x, uint8_t y, uint8_t length);
     };
 
 }